@@ -0,0 +1,487 @@
+#include "scenarios.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// runs every scenario with a fixed seed and reports how long each step took as json.
+// With --compare the results are checked against an earlier run, and the exit code is 1
+// if any scenario got slower than the threshold allows
+
+struct result_t {
+    std::string name;
+    uint32_t bodies   = 0;
+    uint32_t steps    = 0;
+    uint32_t substeps = 0;
+
+    double ms_mean = 0.0;
+    double ms_p50  = 0.0;
+    double ms_p90  = 0.0;
+    double ms_p99  = 0.0;
+    double ms_max  = 0.0;
+
+    double   pairs_mean    = 0.0;
+    double   contacts_mean = 0.0;
+    uint32_t contacts_max  = 0;
+
+    // the peak of the whole process up to the end of this scenario, not of the scenario alone
+    uint64_t process_peak_rss_kb = 0;
+    // of every body's position and rotation at the end, equal checksums mean equal results
+    uint64_t checksum = 0;
+
+    double phase_ms[kin::step_phase_count] = {};
+};
+
+// the peak resident memory of the whole process, so it only grows from one scenario to the next
+static uint64_t peak_rss_kb() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+
+    return (uint64_t)counters.PeakWorkingSetSize / 1024;
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+#if defined(__APPLE__)
+    return (uint64_t)usage.ru_maxrss / 1024; // bytes on macos
+#else
+    return (uint64_t)usage.ru_maxrss;
+#endif
+#endif
+}
+
+static uint64_t checksum_world(kin::world_t& world) {
+    uint64_t hash = 14695981039346656037ull;
+
+    auto add = [&](const void* data, size_t size) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        for(size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+
+    world.for_each_body([&](kin::rigid_body_t* body) {
+        const glm::vec2 pos = body->get_world_pos();
+        const float rot = body->get_world_rot();
+
+        add(&pos, sizeof(pos));
+        add(&rot, sizeof(rot));
+    });
+
+    return hash;
+}
+
+// nearest rank percentile of sorted values
+static double percentile(const std::vector<double>& sorted, double p) {
+    if(sorted.empty())
+        return 0.0;
+
+    size_t rank = (size_t)std::ceil(p * (double)sorted.size());
+    rank = std::clamp<size_t>(rank, 1, sorted.size());
+    return sorted[rank - 1];
+}
+
+static result_t run_scenario(const bench::scenario_t& scenario, uint32_t steps, uint32_t workers, kin::broadphase_type_t broadphase) {
+    using clock = std::chrono::steady_clock;
+
+    result_t result;
+    result.name     = scenario.name;
+    result.steps    = steps;
+    result.substeps = scenario.substeps;
+
+    bench::random_t random(scenario.seed);
+    kin::world_t world;
+    world.set_worker_count(workers);
+    world.set_broadphase(broadphase);
+
+    scenario.setup(world, random);
+
+    std::vector<double> times;
+    times.reserve(steps);
+
+    double pairs    = 0.0;
+    double contacts = 0.0;
+
+    for(uint32_t i = 0; i < steps; i++) {
+        if(scenario.step != nullptr) {
+            scenario.step(world, random, i);
+        }
+
+        const clock::time_point start = clock::now();
+        world.update(1.0f / 60.0f, scenario.substeps);
+        const clock::time_point end = clock::now();
+
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+
+        // the stats are summed over substeps, these are per step
+        const kin::step_stats_t& stats = world.get_step_stats();
+        pairs    += (double)stats.pairs;
+        contacts += (double)stats.contacts;
+        result.contacts_max = std::max(result.contacts_max, stats.contacts);
+
+        for(uint32_t phase = 0; phase < kin::step_phase_count; phase++) {
+            result.phase_ms[phase] += (double)stats.phase_ns[phase] / 1e6;
+        }
+    }
+
+    result.bodies   = (uint32_t)world.count();
+    result.checksum = checksum_world(world);
+    result.process_peak_rss_kb = peak_rss_kb();
+
+    if(steps != 0) {
+        double total = 0.0;
+        for(double time : times) {
+            total += time;
+        }
+
+        result.ms_mean       = total / (double)steps;
+        result.pairs_mean    = pairs / (double)steps;
+        result.contacts_mean = contacts / (double)steps;
+
+        for(double& phase : result.phase_ms) {
+            phase /= (double)steps;
+        }
+    }
+
+    std::sort(times.begin(), times.end());
+    result.ms_p50 = percentile(times, 0.50);
+    result.ms_p90 = percentile(times, 0.90);
+    result.ms_p99 = percentile(times, 0.99);
+    result.ms_max = times.empty() ? 0.0 : times.back();
+
+    return result;
+}
+
+static const char* broadphase_names[] = {"rtree", "sap", "grid"};
+
+static void write_json(FILE* file, const std::vector<result_t>& results, uint32_t workers, kin::broadphase_type_t broadphase) {
+    fprintf(file, "{\n");
+    fprintf(file, "  \"workers\": %u,\n", workers);
+    fprintf(file, "  \"broadphase\": \"%s\",\n", broadphase_names[broadphase]);
+    fprintf(file, "  \"profile\": %s,\n", KIN_PROFILE ? "true" : "false");
+    fprintf(file, "  \"scenarios\": [\n");
+
+    for(size_t i = 0; i < results.size(); i++) {
+        const result_t& result = results[i];
+
+        // every scenario is a flat object, which is all read_json has to handle
+        fprintf(file, "    {\"name\": \"%s\", \"bodies\": %u, \"steps\": %u, \"substeps\": %u, ",
+            result.name.c_str(), result.bodies, result.steps, result.substeps);
+        fprintf(file, "\"ms_mean\": %.4f, \"ms_p50\": %.4f, \"ms_p90\": %.4f, \"ms_p99\": %.4f, \"ms_max\": %.4f, ",
+            result.ms_mean, result.ms_p50, result.ms_p90, result.ms_p99, result.ms_max);
+        fprintf(file, "\"pairs_mean\": %.1f, \"contacts_mean\": %.1f, \"contacts_max\": %u, \"process_peak_rss_kb\": %llu, \"checksum\": \"%016llx\"",
+            result.pairs_mean, result.contacts_mean, result.contacts_max, (unsigned long long)result.process_peak_rss_kb, (unsigned long long)result.checksum);
+
+        // phase timings are all zero without KIN_PROFILE
+        if(KIN_PROFILE) {
+            for(uint32_t phase = 0; phase < kin::step_phase_count; phase++) {
+                fprintf(file, ", \"ms_%s\": %.4f", kin::step_phase_name((kin::step_phase_t)phase), result.phase_ms[phase]);
+            }
+        }
+
+        fprintf(file, "}%s\n", i + 1 == results.size() ? "" : ",");
+    }
+
+    fprintf(file, "  ]\n}\n");
+}
+
+typedef std::map<std::string, std::string> json_object_t;
+
+// reads the scenarios written by write_json, values are kept as text
+static bool read_json(const char* path, std::vector<json_object_t>& scenarios) {
+    FILE* file = fopen(path, "rb");
+    if(file == nullptr)
+        return false;
+
+    std::string text;
+    char buffer[4096];
+    size_t read;
+    while((read = fread(buffer, 1, sizeof(buffer), file)) != 0) {
+        text.append(buffer, read);
+    }
+    fclose(file);
+
+    size_t at = text.find("\"scenarios\"");
+    if(at == std::string::npos)
+        return false;
+
+    at = text.find('[', at);
+    if(at == std::string::npos)
+        return false;
+
+    auto skip_space = [&]() {
+        while(at < text.size() && strchr(" \t\r\n", text[at]) != nullptr)
+            at++;
+    };
+
+    auto read_token = [&](std::string& token) {
+        skip_space();
+        token.clear();
+
+        if(at < text.size() && text[at] == '"') {
+            const size_t end = text.find('"', at + 1);
+            if(end == std::string::npos)
+                return false;
+
+            token = text.substr(at + 1, end - at - 1);
+            at = end + 1;
+            return true;
+        }
+
+        while(at < text.size() && strchr(",}] \t\r\n", text[at]) == nullptr) {
+            token += text[at++];
+        }
+
+        return !token.empty();
+    };
+
+    at++;
+    while(true) {
+        skip_space();
+        if(at >= text.size())
+            return false;
+
+        if(text[at] == ']')
+            return true;
+
+        if(text[at] == ',') {
+            at++;
+            continue;
+        }
+
+        if(text[at] != '{')
+            return false;
+        at++;
+
+        json_object_t& object = scenarios.emplace_back();
+        while(true) {
+            skip_space();
+            if(at < text.size() && text[at] == '}') {
+                at++;
+                break;
+            }
+
+            std::string key, value;
+            if(!read_token(key))
+                return false;
+
+            skip_space();
+            if(at >= text.size() || text[at] != ':')
+                return false;
+            at++;
+
+            if(!read_token(value))
+                return false;
+
+            object[key] = value;
+
+            skip_space();
+            if(at < text.size() && text[at] == ',')
+                at++;
+        }
+    }
+}
+
+// prints every difference against the baseline and returns how many timings regressed
+static int compare(const std::vector<result_t>& results, const std::vector<json_object_t>& baseline, double threshold) {
+    int regressions = 0;
+
+    for(const result_t& result : results) {
+        const json_object_t* base = nullptr;
+        for(const json_object_t& object : baseline) {
+            auto name = object.find("name");
+            if(name != object.end() && name->second == result.name) {
+                base = &object;
+                break;
+            }
+        }
+
+        if(base == nullptr) {
+            printf("%-10s not in the baseline\n", result.name.c_str());
+            continue;
+        }
+
+        auto number = [&](const char* key) {
+            auto value = base->find(key);
+            return value == base->end() ? 0.0 : strtod(value->second.c_str(), nullptr);
+        };
+
+        if(number("steps") != (double)result.steps) {
+            printf("%-10s ran a different number of steps than the baseline, skipped\n", result.name.c_str());
+            continue;
+        }
+
+        struct {
+            const char* key;
+            double value;
+        } const timings[] = {
+            {"ms_p50", result.ms_p50},
+            {"ms_p90", result.ms_p90},
+            {"ms_mean", result.ms_mean},
+        };
+
+        for(const auto& timing : timings) {
+            const double before = number(timing.key);
+            const double change = before > 0.0 ? (timing.value - before) / before : 0.0;
+            const bool regressed = change > threshold;
+
+            printf("%-10s %-8s %10.4f -> %10.4f ms (%+6.1f%%)%s\n", result.name.c_str(), timing.key, before, timing.value, change * 100.0, regressed ? "  REGRESSION" : "");
+            regressions += regressed;
+        }
+
+        // not a regression, but anything that changes the simulation should be noticed
+        auto checksum = base->find("checksum");
+        char current[17];
+        snprintf(current, sizeof(current), "%016llx", (unsigned long long)result.checksum);
+
+        if(checksum != base->end() && checksum->second != current) {
+            printf("%-10s results differ from the baseline (pairs %.1f -> %.1f, contacts %.1f -> %.1f)\n", result.name.c_str(),
+                number("pairs_mean"), result.pairs_mean, number("contacts_mean"), result.contacts_mean);
+        }
+    }
+
+    return regressions;
+}
+
+static void print_usage() {
+    printf(
+        "usage: kin2d_bench [options]\n"
+        "  --list                  list the scenarios and exit\n"
+        "  --scenario <name>       only run this scenario, can be given more than once\n"
+        "  --steps <n>             run every scenario for n steps instead of its own amount\n"
+        "  --workers <n>           extra threads used by the world, 0 by default\n"
+        "  --broadphase <type>     rtree, sap or grid, rtree by default\n"
+        "  --out <path>            write the json results here instead of stdout\n"
+        "  --compare <path>        compare against the json results of an earlier run\n"
+        "  --threshold <percent>   how much slower a timing can get before it is a regression, 10 by default\n");
+}
+
+int main(int argc, char** argv) {
+    uint32_t scenario_count = 0;
+    const bench::scenario_t* scenarios = bench::get_scenarios(scenario_count);
+
+    std::vector<std::string> selected;
+    uint32_t    steps      = 0;
+    uint32_t    workers    = 0;
+    const char* out        = nullptr;
+    const char* baseline   = nullptr;
+    double      threshold  = 0.10;
+    kin::broadphase_type_t broadphase = kin::broadphase_type_rtree;
+
+    for(int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if(strcmp(arg, "--list") == 0) {
+            for(uint32_t s = 0; s < scenario_count; s++) {
+                printf("%-10s %s, %u steps\n", scenarios[s].name, scenarios[s].description, scenarios[s].steps);
+            }
+            return 0;
+        } else if(strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage();
+            return 0;
+        } else if(value == nullptr) {
+            print_usage();
+            return 1;
+        } else if(strcmp(arg, "--scenario") == 0) {
+            selected.push_back(value);
+        } else if(strcmp(arg, "--steps") == 0) {
+            steps = (uint32_t)strtoul(value, nullptr, 10);
+        } else if(strcmp(arg, "--workers") == 0) {
+            workers = (uint32_t)strtoul(value, nullptr, 10);
+        } else if(strcmp(arg, "--broadphase") == 0) {
+            bool found = false;
+            for(uint32_t type = 0; type < 3; type++) {
+                if(strcmp(value, broadphase_names[type]) == 0) {
+                    broadphase = (kin::broadphase_type_t)type;
+                    found = true;
+                }
+            }
+
+            if(!found) {
+                printf("unknown broadphase %s\n", value);
+                return 1;
+            }
+        } else if(strcmp(arg, "--out") == 0) {
+            out = value;
+        } else if(strcmp(arg, "--compare") == 0) {
+            baseline = value;
+        } else if(strcmp(arg, "--threshold") == 0) {
+            threshold = strtod(value, nullptr) / 100.0;
+        } else {
+            print_usage();
+            return 1;
+        }
+
+        i++;
+    }
+
+    for(const std::string& name : selected) {
+        bool found = false;
+        for(uint32_t s = 0; s < scenario_count; s++) {
+            found |= name == scenarios[s].name;
+        }
+
+        if(!found) {
+            printf("unknown scenario %s, see --list\n", name.c_str());
+            return 1;
+        }
+    }
+
+    // read before running so that a bad path doesn't waste a whole run
+    std::vector<json_object_t> baseline_results;
+    if(baseline != nullptr && !read_json(baseline, baseline_results)) {
+        printf("could not read %s\n", baseline);
+        return 1;
+    }
+
+    std::vector<result_t> results;
+    for(uint32_t s = 0; s < scenario_count; s++) {
+        const bench::scenario_t& scenario = scenarios[s];
+        if(!selected.empty() && std::find(selected.begin(), selected.end(), scenario.name) == selected.end())
+            continue;
+
+        // progress goes to stderr so stdout stays valid json
+        fprintf(stderr, "%s...\n", scenario.name);
+        results.push_back(run_scenario(scenario, steps != 0 ? steps : scenario.steps, workers, broadphase));
+    }
+
+    FILE* file = out != nullptr ? fopen(out, "w") : stdout;
+    if(file == nullptr) {
+        printf("could not open %s\n", out);
+        return 1;
+    }
+
+    // with a baseline the comparison goes to stdout instead
+    if(baseline == nullptr || out != nullptr) {
+        write_json(file, results, workers, broadphase);
+    }
+
+    if(file != stdout) {
+        fclose(file);
+    }
+
+    if(baseline != nullptr) {
+        const int regressions = compare(results, baseline_results, threshold);
+        printf("%d regression%s\n", regressions, regressions == 1 ? "" : "s");
+        return regressions == 0 ? 0 : 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,512 @@
+#include "random.hpp"
+#include "perf_counters.hpp"
+#include <kin2d/kin2d.hpp>
+#include <kin2d/collision.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+
+// times the collision primitives one at a time on generated datasets, separate from the
+// world scenarios in main.cpp. Every kernel runs in passes over its dataset, a pass is repeated
+// until a sample takes long enough to time, and the median of the samples is reported together
+// with its median absolute deviation. Hardware counters are added where perf_event_open works
+
+constexpr uint32_t dataset_size = 1024;
+
+// keeps the compiler from removing a computation whose result is never used
+template<typename T>
+inline void keep(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile char sink;
+    sink = *(const volatile char*)&value;
+#endif
+}
+
+struct options_t {
+    uint32_t    samples   = 21;
+    double      sample_ns = 2e6;
+    const char* filter    = nullptr;
+};
+
+struct measurement_t {
+    std::string kernel;
+    std::string dataset;
+
+    double ns_median = 0.0;
+    double ns_mad    = 0.0;
+    double ns_min    = 0.0;
+
+    // per op, only filled when counters are available
+    double counters[bench::perf_counter_count] = {};
+};
+
+static options_t options;
+static bench::perf_counters_t* counters = nullptr;
+static std::vector<measurement_t> measurements;
+
+static double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const size_t middle = values.size() / 2;
+
+    return values.size() % 2 == 1 ? values[middle] : (values[middle - 1] + values[middle]) * 0.5;
+}
+
+// runs pass, which does ops operations, and records the time and counters per operation
+template<typename F>
+static void measure(const char* kernel, const char* dataset, uint32_t ops, F&& pass) {
+    using clock = std::chrono::steady_clock;
+
+    const std::string name = std::string(kernel) + "/" + dataset;
+    if(options.filter != nullptr && name.find(options.filter) == std::string::npos)
+        return;
+
+    auto run = [&](uint32_t passes) {
+        const clock::time_point start = clock::now();
+        for(uint32_t i = 0; i < passes; i++) {
+            pass();
+        }
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+    };
+
+    // doubles the passes per sample until a sample is long enough, which also warms the caches up
+    uint32_t passes = 1;
+    while(run(passes) < options.sample_ns && passes < (1u << 24)) {
+        passes *= 2;
+    }
+
+    std::vector<double> samples(options.samples);
+
+    counters->start();
+    for(double& sample : samples) {
+        sample = run(passes) / ((double)passes * (double)ops);
+    }
+
+    uint64_t values[bench::perf_counter_count];
+    counters->stop(values);
+
+    measurement_t& measurement = measurements.emplace_back();
+    measurement.kernel    = kernel;
+    measurement.dataset   = dataset;
+    measurement.ns_median = median(samples);
+    measurement.ns_min    = *std::min_element(samples.begin(), samples.end());
+
+    std::vector<double> deviations(samples.size());
+    for(size_t i = 0; i < samples.size(); i++) {
+        deviations[i] = std::abs(samples[i] - measurement.ns_median);
+    }
+    measurement.ns_mad = median(deviations);
+
+    const double total_ops = (double)options.samples * (double)passes * (double)ops;
+    for(uint32_t i = 0; i < bench::perf_counter_count; i++) {
+        measurement.counters[i] = (double)values[i] / total_ops;
+    }
+
+    printf("%-24s %-12s %9.2f ns/op  +-%5.1f%%  min %9.2f", kernel, dataset, measurement.ns_median,
+        measurement.ns_median > 0.0 ? measurement.ns_mad / measurement.ns_median * 100.0 : 0.0, measurement.ns_min);
+
+    if(counters->available()) {
+        const double cycles       = measurement.counters[bench::perf_counter_cycles];
+        const double instructions = measurement.counters[bench::perf_counter_instructions];
+
+        printf("  %8.1f cyc  %8.1f ins  %4.2f ipc  %6.3f br-miss  %6.3f cache-miss", cycles, instructions, cycles > 0.0 ? instructions / cycles : 0.0,
+            measurement.counters[bench::perf_counter_branch_misses], measurement.counters[bench::perf_counter_cache_misses]);
+    }
+
+    printf("\n");
+}
+
+// the proxy fixture_t::update_vertices would compute for a box on its own body
+static kin::collision_proxy_t make_proxy(glm::vec2 center, float rot, float hw, float hh) {
+    const float sin = std::sin(rot);
+    const float cos = std::cos(rot);
+
+    const kin::box_vertices_t local_vertices = {
+        glm::vec2(-hw, -hh),
+        glm::vec2( hw, -hh),
+        glm::vec2( hw,  hh),
+        glm::vec2(-hw,  hh)
+    };
+
+    kin::collision_proxy_t proxy;
+    proxy.normals[0] = kin::fast_rotate_w_precalc(glm::vec2(-1.0f, 0.0f ), sin, cos);
+    proxy.normals[1] = kin::fast_rotate_w_precalc(glm::vec2( 0.0f, -1.0f), sin, cos);
+
+    proxy.aabb.min[0] = kin::float_max;
+    proxy.aabb.min[1] = kin::float_max;
+    proxy.aabb.max[0] = -kin::float_max;
+    proxy.aabb.max[1] = -kin::float_max;
+
+    for(int i = 0; i < 4; i++) {
+        const glm::vec2 vertex = kin::fast_rotate_w_precalc(local_vertices[i], sin, cos) + center;
+        proxy.world_vertices[i] = vertex;
+
+        proxy.aabb.min[0] = std::min(proxy.aabb.min[0], vertex.x);
+        proxy.aabb.min[1] = std::min(proxy.aabb.min[1], vertex.y);
+        proxy.aabb.max[0] = std::max(proxy.aabb.max[0], vertex.x);
+        proxy.aabb.max[1] = std::max(proxy.aabb.max[1], vertex.y);
+    }
+
+    return proxy;
+}
+
+enum dataset_type_t {
+    dataset_separated = 0, // far enough apart that no axis overlaps
+    dataset_touching,      // axis aligned and sharing an edge, depth is exactly 0
+    dataset_overlapping,   // deep overlap, centers close together
+    dataset_rotated,       // random rotations, always overlapping a little
+    dataset_axis_aligned,  // no rotation, always overlapping a little
+    dataset_count
+};
+
+static const char* dataset_names[dataset_count] = {"separated", "touching", "overlapping", "rotated", "axis_aligned"};
+
+struct dataset_t {
+    const char* name;
+    std::vector<kin::collision_proxy_t> proxies1;
+    std::vector<kin::collision_proxy_t> proxies2;
+    std::vector<glm::vec2> centers1;
+    std::vector<glm::vec2> centers2;
+};
+
+static dataset_t generate_dataset(dataset_type_t type, uint64_t seed) {
+    bench::random_t random(seed);
+
+    dataset_t dataset;
+    dataset.name = dataset_names[type];
+
+    for(uint32_t i = 0; i < dataset_size; i++) {
+        const float hw1 = random.range(0.25f, 2.0f), hh1 = random.range(0.25f, 2.0f);
+        const float hw2 = random.range(0.25f, 2.0f), hh2 = random.range(0.25f, 2.0f);
+        const float angle = random.range(0.0f, 6.2831853f);
+        const glm::vec2 direction = {std::cos(angle), std::sin(angle)};
+
+        // spread the pairs out so that they aren't all in the same spot
+        const glm::vec2 center1 = {random.range(-100.0f, 100.0f), random.range(-100.0f, 100.0f)};
+        glm::vec2 center2 = center1;
+        float rot1 = 0.0f;
+        float rot2 = 0.0f;
+
+        // the boxes' inscribed and circumscribed radii
+        const float inner = std::min(hw1, hh1) + std::min(hw2, hh2);
+        const float outer = std::sqrt(hw1 * hw1 + hh1 * hh1) + std::sqrt(hw2 * hw2 + hh2 * hh2);
+
+        switch(type) {
+        case dataset_separated:
+            rot1 = random.range(0.0f, 3.14159f);
+            rot2 = random.range(0.0f, 3.14159f);
+            center2 += direction * (outer + random.range(0.1f, 2.0f));
+            break;
+        case dataset_touching:
+            if(random.next() % 2 == 0) {
+                center2 += glm::vec2(hw1 + hw2, random.range(-0.5f, 0.5f) * (hh1 + hh2));
+            } else {
+                center2 += glm::vec2(random.range(-0.5f, 0.5f) * (hw1 + hw2), hh1 + hh2);
+            }
+            break;
+        case dataset_overlapping:
+            rot1 = random.range(0.0f, 3.14159f);
+            rot2 = random.range(0.0f, 3.14159f);
+            center2 += direction * inner * random.range(0.0f, 0.25f);
+            break;
+        case dataset_rotated:
+            rot1 = random.range(0.0f, 3.14159f);
+            rot2 = random.range(0.0f, 3.14159f);
+            center2 += direction * inner * random.range(0.5f, 1.0f);
+            break;
+        case dataset_axis_aligned:
+            center2 += direction * inner * random.range(0.5f, 1.0f);
+            break;
+        default:
+            break;
+        }
+
+        dataset.proxies1.push_back(make_proxy(center1, rot1, hw1, hh1));
+        dataset.proxies2.push_back(make_proxy(center2, rot2, hw2, hh2));
+        dataset.centers1.push_back(center1);
+        dataset.centers2.push_back(center2);
+    }
+
+    return dataset;
+}
+
+static void bench_pairs(const dataset_t& dataset) {
+    const kin::collision_proxy_t* proxies1 = dataset.proxies1.data();
+    const kin::collision_proxy_t* proxies2 = dataset.proxies2.data();
+
+    measure("aabb_collide", dataset.name, dataset_size, [&]() {
+        for(uint32_t i = 0; i < dataset_size; i++) {
+            keep(kin::aabb_collide(proxies1[i].aabb, proxies2[i].aabb));
+        }
+    });
+
+    measure("sat_test", dataset.name, dataset_size, [&]() {
+        kin::collision_manifold_t manifold;
+        for(uint32_t i = 0; i < dataset_size; i++) {
+            keep(kin::sat_test(proxies1[i], proxies2[i], manifold));
+            keep(manifold.depth);
+        }
+    });
+
+    // packed up front, this only times the kernel
+    std::vector<kin::sat_batch_t> batches(dataset_size / kin::sat_batch_size);
+    for(uint32_t i = 0; i < dataset_size; i++) {
+        batches[i / kin::sat_batch_size].set(i % kin::sat_batch_size, proxies1[i], proxies2[i]);
+    }
+
+    for(int level = kin::simd_level_scalar; level <= kin::detect_simd_level(); level++) {
+        const std::string kernel = std::string("sat_test_batch_") + kin::simd_level_name((kin::simd_level_t)level);
+
+        measure(kernel.c_str(), dataset.name, dataset_size, [&]() {
+            kin::sat_batch_result_t result;
+            for(const kin::sat_batch_t& batch : batches) {
+                kin::sat_test_batch(batch, kin::sat_batch_size, result, (kin::simd_level_t)level);
+                keep(result);
+            }
+        });
+    }
+
+    measure("compute_manifold", dataset.name, dataset_size, [&]() {
+        for(uint32_t i = 0; i < dataset_size; i++) {
+            kin::collision_manifold_t manifold;
+            kin::compute_manifold(proxies1[i], proxies2[i], manifold);
+            keep(manifold.points);
+        }
+    });
+}
+
+// impulse_method changes the velocities it reads, so every call first restores them,
+// that restore is part of the time
+static void bench_impulse(const dataset_t& dataset) {
+    kin::world_t world({0.0f, 0.0f});
+
+    struct contact_t {
+        kin::rigid_body_t* body1;
+        kin::rigid_body_t* body2;
+        kin::collision_manifold_t manifold;
+        glm::vec2 vel1, vel2;
+    };
+
+    std::vector<contact_t> contacts;
+    contacts.reserve(dataset_size);
+
+    for(uint32_t i = 0; i < dataset_size; i++) {
+        kin::collision_manifold_t manifold;
+        if(!kin::sat_test(dataset.proxies1[i], dataset.proxies2[i], manifold))
+            continue;
+
+        kin::compute_manifold(dataset.proxies1[i], dataset.proxies2[i], manifold);
+        manifold.restitution      = 0.2f;
+        manifold.static_friction  = 0.6f;
+        manifold.dynamic_friction = 0.4f;
+
+        contact_t& contact = contacts.emplace_back();
+        contact.body1 = world.create_rigid_body(dataset.centers1[i], 0.0f, kin::body_type_dynamic);
+        contact.body2 = world.create_rigid_body(dataset.centers2[i], 0.0f, kin::body_type_dynamic);
+        contact.body1->create_fixture(kin::fixture_def_t());
+        contact.body2->create_fixture(kin::fixture_def_t());
+        contact.manifold = manifold;
+
+        // approaching along the normal with some sliding, so both the normal and friction parts run
+        contact.vel1 = manifold.normal * 2.0f + glm::vec2(manifold.normal.y, -manifold.normal.x);
+        contact.vel2 = -manifold.normal * 2.0f;
+    }
+
+    if(contacts.empty())
+        return;
+
+    measure("impulse_method", dataset.name, (uint32_t)contacts.size(), [&]() {
+        for(contact_t& contact : contacts) {
+            contact.body1->linear_vel()  = contact.vel1;
+            contact.body2->linear_vel()  = contact.vel2;
+            contact.body1->angular_vel() = 0.0f;
+            contact.body2->angular_vel() = 0.0f;
+
+            kin::impulse_method(*contact.body1, *contact.body2, contact.manifold);
+            keep(contact.body2->linear_vel());
+        }
+    });
+}
+
+static void bench_transforms() {
+    bench::random_t random(100);
+
+    kin::world_t world({0.0f, 0.0f});
+    std::vector<kin::fixture_t*> fixtures;
+
+    for(uint32_t i = 0; i < dataset_size; i++) {
+        const glm::vec2 pos = {random.range(-100.0f, 100.0f), random.range(-100.0f, 100.0f)};
+        kin::rigid_body_t* body = world.create_rigid_body(pos, random.range(0.0f, 6.2831853f), kin::body_type_dynamic);
+
+        kin::fixture_def_t def;
+        def.hw = random.range(0.25f, 2.0f);
+        def.hh = random.range(0.25f, 2.0f);
+        def.rel_pos = {random.range(-1.0f, 1.0f), random.range(-1.0f, 1.0f)};
+        fixtures.push_back(body->create_fixture(def));
+    }
+
+    measure("update_vertices", "fixtures", dataset_size, [&]() {
+        for(kin::fixture_t* fixture : fixtures) {
+            fixture->update_vertices();
+        }
+        keep(world.proxy(fixtures[0]->relement_id));
+    });
+
+    std::vector<kin::box_batch_t> batches(dataset_size / kin::box_batch_size);
+    for(uint32_t i = 0; i < dataset_size; i++) {
+        kin::box_batch_t& batch = batches[i / kin::box_batch_size];
+        const uint32_t lane = i % kin::box_batch_size;
+        const kin::fixture_t* fixture = fixtures[i];
+        const kin::rigid_body_t* body = fixture->body;
+
+        batch.pos_x[lane]  = fixture->pos.x;
+        batch.pos_y[lane]  = fixture->pos.y;
+        batch.hw[lane]     = fixture->hw;
+        batch.hh[lane]     = fixture->hh;
+        batch.com_x[lane]  = body->center_of_mass.x;
+        batch.com_y[lane]  = body->center_of_mass.y;
+        batch.body_x[lane] = body->pos().x;
+        batch.body_y[lane] = body->pos().y;
+        batch.sin[lane]    = body->psin();
+        batch.cos[lane]    = body->pcos();
+    }
+
+    for(int level = kin::simd_level_scalar; level <= kin::detect_simd_level(); level++) {
+        const std::string kernel = std::string("transform_box_batch_") + kin::simd_level_name((kin::simd_level_t)level);
+
+        measure(kernel.c_str(), "fixtures", dataset_size, [&]() {
+            for(kin::box_batch_t& batch : batches) {
+                kin::transform_box_batch(batch, kin::box_batch_size, (kin::simd_level_t)level);
+            }
+            keep(batches[0]);
+        });
+    }
+
+    std::vector<glm::vec2> points(dataset_size);
+    std::vector<float> angles(dataset_size);
+    for(uint32_t i = 0; i < dataset_size; i++) {
+        points[i] = {random.range(-10.0f, 10.0f), random.range(-10.0f, 10.0f)};
+        angles[i] = random.range(-6.2831853f, 6.2831853f);
+    }
+
+    measure("fast_rotate", "points", dataset_size, [&]() {
+        for(uint32_t i = 0; i < dataset_size; i++) {
+            keep(kin::fast_rotate(points[i], angles[i]));
+        }
+    });
+
+    // the polynomial against the standard library. Every angle is inside fast_sincos_range, so
+    // neither version takes the fallback, and the loop in the array version should vectorize
+    std::vector<glm::vec2> sincos(dataset_size);
+    measure("fast_sincos", "angles", dataset_size, [&]() {
+        for(uint32_t i = 0; i < dataset_size; i++) {
+            kin::fast_sincos(angles[i], sincos[i].x, sincos[i].y);
+        }
+        keep(sincos[0]);
+    });
+
+    std::vector<float> sins(dataset_size), coss(dataset_size);
+    measure("fast_sincos_array", "angles", dataset_size, [&]() {
+        kin::fast_sincos(angles.data(), sins.data(), coss.data(), dataset_size);
+        keep(sins[0]);
+        keep(coss[0]);
+    });
+
+    measure("std_sincos", "angles", dataset_size, [&]() {
+        for(uint32_t i = 0; i < dataset_size; i++) {
+            sincos[i] = {std::sin(angles[i]), std::cos(angles[i])};
+        }
+        keep(sincos[0]);
+    });
+}
+
+static void write_json(const char* path) {
+    FILE* file = fopen(path, "w");
+    if(file == nullptr) {
+        printf("could not open %s\n", path);
+        return;
+    }
+
+    fprintf(file, "{\n  \"counters\": %s,\n  \"results\": [\n", counters->available() ? "true" : "false");
+
+    for(size_t i = 0; i < measurements.size(); i++) {
+        const measurement_t& measurement = measurements[i];
+
+        fprintf(file, "    {\"kernel\": \"%s\", \"dataset\": \"%s\", \"ns_median\": %.3f, \"ns_mad\": %.3f, \"ns_min\": %.3f",
+            measurement.kernel.c_str(), measurement.dataset.c_str(), measurement.ns_median, measurement.ns_mad, measurement.ns_min);
+
+        for(uint32_t c = 0; c < bench::perf_counter_count; c++) {
+            if(counters->has((bench::perf_counter_t)c)) {
+                fprintf(file, ", \"%s\": %.3f", bench::perf_counter_name((bench::perf_counter_t)c), measurement.counters[c]);
+            }
+        }
+
+        fprintf(file, "}%s\n", i + 1 == measurements.size() ? "" : ",");
+    }
+
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+}
+
+static void print_usage() {
+    printf(
+        "usage: kin2d_microbench [options]\n"
+        "  --filter <text>      only run kernels whose kernel/dataset name contains text\n"
+        "  --samples <n>        samples per kernel, 21 by default\n"
+        "  --sample-ms <ms>     how long a single sample should take at least, 2 by default\n"
+        "  --json <path>        also write the results as json\n");
+}
+
+int main(int argc, char** argv) {
+    const char* json = nullptr;
+
+    for(int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if(strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage();
+            return 0;
+        } else if(value == nullptr) {
+            print_usage();
+            return 1;
+        } else if(strcmp(arg, "--filter") == 0) {
+            options.filter = value;
+        } else if(strcmp(arg, "--samples") == 0) {
+            options.samples = std::max(1u, (uint32_t)strtoul(value, nullptr, 10));
+        } else if(strcmp(arg, "--sample-ms") == 0) {
+            options.sample_ns = strtod(value, nullptr) * 1e6;
+        } else if(strcmp(arg, "--json") == 0) {
+            json = value;
+        } else {
+            print_usage();
+            return 1;
+        }
+
+        i++;
+    }
+
+    bench::perf_counters_t perf_counters;
+    counters = &perf_counters;
+
+    printf("simd level %s, hardware counters %s\n", kin::simd_level_name(kin::detect_simd_level()),
+        counters->available() ? "on" : "unavailable");
+
+    for(int type = 0; type < dataset_count; type++) {
+        const dataset_t dataset = generate_dataset((dataset_type_t)type, 1 + (uint64_t)type);
+
+        bench_pairs(dataset);
+        bench_impulse(dataset);
+    }
+
+    bench_transforms();
+
+    if(json != nullptr) {
+        write_json(json);
+    }
+
+    return 0;
+}
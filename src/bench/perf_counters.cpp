@@ -0,0 +1,113 @@
+#include "perf_counters.hpp"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace bench {
+    const char* perf_counter_name(perf_counter_t counter) {
+        switch(counter) {
+        case perf_counter_cycles:        return "cycles";
+        case perf_counter_instructions:  return "instructions";
+        case perf_counter_branch_misses: return "branch_misses";
+        case perf_counter_cache_misses:  return "cache_misses";
+        default:                         return "unknown";
+        }
+    }
+
+#if defined(__linux__)
+    static int open_counter(uint64_t config, int group) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type           = PERF_TYPE_HARDWARE;
+        attr.size           = sizeof(attr);
+        attr.config         = config;
+        attr.disabled       = group == -1 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+    }
+
+    perf_counters_t::perf_counters_t() {
+        const uint64_t configs[perf_counter_count] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_BRANCH_MISSES,
+            PERF_COUNT_HW_CACHE_MISSES,
+        };
+
+        // every counter is in the cycle counter's group, so they all count over the exact same time
+        fds[0] = open_counter(configs[0], -1);
+        for(int i = 1; i < perf_counter_count; i++) {
+            fds[i] = fds[0] == -1 ? -1 : open_counter(configs[i], fds[0]);
+        }
+    }
+
+    perf_counters_t::~perf_counters_t() {
+        for(int fd : fds) {
+            if(fd != -1) {
+                close(fd);
+            }
+        }
+    }
+
+    void perf_counters_t::start() {
+        if(!available())
+            return;
+
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    void perf_counters_t::stop(uint64_t (&values)[perf_counter_count]) {
+        memset(values, 0, sizeof(values));
+
+        if(!available())
+            return;
+
+        ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // nr, time enabled, time running, then a value and id per counter
+        uint64_t data[3 + 2 * perf_counter_count];
+        if(read(fds[0], data, sizeof(data)) < (ssize_t)(3 * sizeof(uint64_t)))
+            return;
+
+        const uint64_t count   = data[0];
+        const uint64_t enabled = data[1];
+        const uint64_t running = data[2];
+        const double   scale   = running != 0 ? (double)enabled / (double)running : 0.0;
+
+        // values come back in the order the counters were opened in, missing counters are skipped
+        uint64_t next = 0;
+        for(int i = 0; i < perf_counter_count && next < count; i++) {
+            if(fds[i] == -1)
+                continue;
+
+            values[i] = (uint64_t)((double)data[3 + next * 2] * scale);
+            next++;
+        }
+    }
+#else
+    perf_counters_t::perf_counters_t() {
+        for(int& fd : fds) {
+            fd = -1;
+        }
+    }
+
+    perf_counters_t::~perf_counters_t() {}
+
+    void perf_counters_t::start() {}
+
+    void perf_counters_t::stop(uint64_t (&values)[perf_counter_count]) {
+        for(uint64_t& value : values) {
+            value = 0;
+        }
+    }
+#endif
+}
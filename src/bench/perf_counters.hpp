@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bench {
+    enum perf_counter_t {
+        perf_counter_cycles = 0,
+        perf_counter_instructions,
+        perf_counter_branch_misses,
+        perf_counter_cache_misses,
+        perf_counter_count
+    };
+
+    const char* perf_counter_name(perf_counter_t counter);
+
+    // hardware counters of the calling thread through perf_event_open. Only on linux, and only
+    // when the kernel allows it (see /proc/sys/kernel/perf_event_paranoid), otherwise available is false
+    class perf_counters_t {
+    public:
+        perf_counters_t();
+        ~perf_counters_t();
+
+        perf_counters_t(const perf_counters_t&) = delete;
+        perf_counters_t& operator=(const perf_counters_t&) = delete;
+
+        bool available() const { return fds[0] != -1; }
+        // a single counter can be missing even if the others work, its value stays 0
+        bool has(perf_counter_t counter) const { return fds[counter] != -1; }
+
+        // zeroes every counter and starts counting
+        void start();
+        // stops counting and fills values, scaled up if the kernel had to share the counters
+        void stop(uint64_t (&values)[perf_counter_count]);
+
+    private:
+        int fds[perf_counter_count];
+    };
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bench {
+    // a small pcg style generator, std::uniform_real_distribution is not the same on
+    // every standard library, which would make scenarios differ between platforms
+    struct random_t {
+        uint64_t state;
+
+        explicit random_t(uint64_t seed) : state(seed) {}
+
+        uint32_t next() {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            return (uint32_t)(state >> 32);
+        }
+
+        float range(float min, float max) {
+            return min + (max - min) * (float)(next() >> 8) * (1.0f / 16777216.0f);
+        }
+    };
+}
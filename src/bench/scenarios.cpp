@@ -0,0 +1,170 @@
+#include "scenarios.hpp"
+
+namespace bench {
+    static kin::rigid_body_t* create_box(kin::world_t& world, glm::vec2 pos, float rot, float hw, float hh) {
+        kin::fixture_def_t def;
+        def.hw = hw;
+        def.hh = hh;
+
+        kin::rigid_body_t* body = world.create_rigid_body(pos, rot, kin::body_type_dynamic);
+        body->create_fixture(def);
+        return body;
+    }
+
+    static void create_ground(kin::world_t& world, float hw) {
+        kin::fixture_def_t def;
+        def.hw = hw;
+        def.hh = 1.0f;
+
+        // the top of the ground is at y = 0
+        world.create_rigid_body({0.0f, -1.0f}, 0.0f, kin::body_type_static)->create_fixture(def);
+    }
+
+    // a pyramid of unit boxes with 40 boxes at its base, settles into a stack that never sleeps until late
+    static void setup_pyramid(kin::world_t& world, random_t&) {
+        constexpr int base = 40;
+
+        create_ground(world, 100.0f);
+
+        for(int row = 0; row < base; row++) {
+            const int count = base - row;
+
+            for(int i = 0; i < count; i++) {
+                const float x = ((float)i - (float)(count - 1) * 0.5f) * 1.05f;
+                create_box(world, {x, 0.5f + (float)row}, 0.0f, 0.5f, 0.5f);
+            }
+        }
+    }
+
+    // rolling static tile terrain, boxes of random size are dropped onto it for the first 250 steps
+    static void setup_rain(kin::world_t& world, random_t& random) {
+        constexpr uint32_t width  = 256;
+        constexpr uint32_t height = 32;
+
+        kin::tile_grid_def_t def;
+        def.width     = width;
+        def.height    = height;
+        def.tile_size = 0.5f;
+        def.offset    = {-(float)width * def.tile_size * 0.5f, -(float)height * def.tile_size};
+
+        kin::rigid_body_t* terrain = world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_static);
+        kin::tile_grid_t* grid = terrain->create_tile_grid(def);
+
+        // a random walk heightmap with walls at both ends
+        int ground = (int)height / 2;
+        for(uint32_t x = 0; x < width; x++) {
+            ground += (int)(random.next() % 3) - 1;
+            ground  = std::clamp(ground, 4, (int)height - 2);
+
+            const int top = (x < 2 || x >= width - 2) ? (int)height : ground;
+            for(int y = 0; y < top; y++) {
+                grid->set_tile(x, (uint32_t)y, true);
+            }
+        }
+
+        grid->update();
+    }
+
+    static void step_rain(kin::world_t& world, random_t& random, uint32_t step) {
+        if(step >= 250)
+            return;
+
+        for(int i = 0; i < 8; i++) {
+            const glm::vec2 pos = {random.range(-60.0f, 60.0f), random.range(10.0f, 30.0f)};
+            const float hw = random.range(0.25f, 0.75f);
+            const float hh = random.range(0.25f, 0.75f);
+
+            create_box(world, pos, random.range(0.0f, 3.14159f), hw, hh);
+        }
+    }
+
+    // large dynamic tile grids with holes in them flying into each other without gravity
+    static void setup_ships(kin::world_t& world, random_t& random) {
+        constexpr uint32_t width  = 48;
+        constexpr uint32_t height = 24;
+
+        world.set_gravity({0.0f, 0.0f});
+
+        kin::tile_grid_def_t def;
+        def.width     = width;
+        def.height    = height;
+        def.tile_size = 0.5f;
+        def.offset    = {-(float)width * def.tile_size * 0.5f, -(float)height * def.tile_size * 0.5f};
+
+        for(int i = 0; i < 8; i++) {
+            const float side = i % 2 == 0 ? -1.0f : 1.0f;
+            const glm::vec2 pos = {side * 20.0f, (float)(i / 2) * 14.0f + random.range(-3.0f, 3.0f)};
+
+            kin::rigid_body_t* ship = world.create_rigid_body(pos, random.range(-0.2f, 0.2f), kin::body_type_dynamic);
+            kin::tile_grid_t* grid = ship->create_tile_grid(def);
+
+            for(uint32_t y = 0; y < height; y++) {
+                for(uint32_t x = 0; x < width; x++) {
+                    // a solid hull around rooms with some tiles missing
+                    const bool hull = x == 0 || y == 0 || x == width - 1 || y == height - 1;
+                    const bool wall = x % 8 == 0 || y % 6 == 0;
+
+                    if(hull || (wall && random.next() % 10 != 0)) {
+                        grid->set_tile(x, y, true);
+                    }
+                }
+            }
+
+            grid->update();
+            ship->apply_linear_velocity({-side * 6.0f, random.range(-1.0f, 1.0f)});
+            ship->apply_angular_velocity(random.range(-0.3f, 0.3f));
+        }
+    }
+
+    // columns of boxes placed at rest, so nearly every body sleeps, every 30 steps a random box is knocked
+    static void setup_sleeping(kin::world_t& world, random_t&) {
+        create_ground(world, 300.0f);
+
+        for(int column = 0; column < 250; column++) {
+            for(int i = 0; i < 10; i++) {
+                create_box(world, {(float)column * 2.0f - 250.0f, 0.5f + (float)i}, 0.0f, 0.5f, 0.5f);
+            }
+        }
+    }
+
+    static void step_sleeping(kin::world_t& world, random_t& random, uint32_t step) {
+        if(step == 0 || step % 30 != 0)
+            return;
+
+        // bodies are in creation order, the ground is body 0
+        const uint32_t target = 1 + random.next() % 2500;
+        uint32_t index = 0;
+
+        world.for_each_body([&](kin::rigid_body_t* body) {
+            if(index++ == target) {
+                body->wake();
+                body->apply_linear_velocity({random.range(-4.0f, 4.0f), random.range(0.0f, 4.0f)});
+            }
+        });
+    }
+
+    // 100k small boxes dropped onto the ground at once
+    static void setup_stress(kin::world_t& world, random_t& random) {
+        create_ground(world, 300.0f);
+
+        for(int y = 0; y < 200; y++) {
+            for(int x = 0; x < 500; x++) {
+                const glm::vec2 pos = {(float)x * 1.0f - 250.0f + random.range(-0.05f, 0.05f), 1.0f + (float)y * 1.0f};
+                create_box(world, pos, 0.0f, 0.4f, 0.4f);
+            }
+        }
+    }
+
+    static const scenario_t scenarios[] = {
+        {"pyramid",  "a 40 box wide pyramid",                       300, 8, 1, setup_pyramid,  nullptr},
+        {"rain",     "2000 boxes dropped onto static tile terrain", 600, 8, 2, setup_rain,     step_rain},
+        {"ships",    "8 large tile grid ships colliding",           300, 8, 3, setup_ships,    nullptr},
+        {"sleeping", "2500 resting boxes, one knocked every 30",    600, 8, 4, setup_sleeping, step_sleeping},
+        {"stress",   "100k boxes dropped at once",                   60, 4, 5, setup_stress,   nullptr},
+    };
+
+    const scenario_t* get_scenarios(uint32_t& count) {
+        count = (uint32_t)(sizeof(scenarios) / sizeof(scenarios[0]));
+        return scenarios;
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "random.hpp"
+#include <kin2d/kin2d.hpp>
+
+namespace bench {
+    struct scenario_t {
+        const char* name;
+        const char* description;
+        uint32_t steps;
+        uint32_t substeps;
+        uint64_t seed;
+
+        // fills an empty world
+        void (*setup)(kin::world_t& world, random_t& random);
+        // called before every step, may be null
+        void (*step)(kin::world_t& world, random_t& random, uint32_t step);
+    };
+
+    // every scenario, roughly from the smallest to the largest
+    const scenario_t* get_scenarios(uint32_t& count);
+}
@@ -25,6 +25,12 @@ namespace kin {
         return true;
     }
 
+    // does outer fully contain inner
+    inline bool aabb_contains(const aabb_t& outer, const aabb_t& inner) {
+        return outer.min[0] <= inner.min[0] && outer.min[1] <= inner.min[1] &&
+               inner.max[0] <= outer.max[0] && inner.max[1] <= outer.max[1];
+    }
+
     typedef std::array<glm::vec2, 4> box_vertices_t;
     typedef std::array<glm::vec2, 2> box_normals_t;
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "arena.hpp"
+
+namespace kin {
+    frame_arena_t::frame_arena_t(size_t initial_size) {
+        add_block(initial_size);
+    }
+
+    frame_arena_t::~frame_arena_t() {
+        for(block_t& block : blocks) {
+            ::operator delete(block.data);
+        }
+    }
+
+    void frame_arena_t::add_block(size_t min_size) {
+        size_t size = min_size;
+        if(!blocks.empty()) {
+            size = std::max(size, blocks.back().size * 2);
+        }
+
+        blocks.push_back({(uint8_t*)::operator new(size), size});
+        offset = 0;
+    }
+
+    void* frame_arena_t::allocate(size_t size, size_t align) {
+        // the block data comes from operator new which is aligned 
+        // to at least alignof(std::max_align_t)
+        size_t aligned = (offset + align - 1) & ~(align - 1);
+
+        if(aligned + size > blocks.back().size) {
+            add_block(size + align);
+            aligned = 0;
+        }
+
+        offset = aligned + size;
+        used_total += size;
+
+        return blocks.back().data + aligned;
+    }
+
+    void frame_arena_t::reset() {
+        if(blocks.size() > 1) {
+            size_t total = capacity();
+
+            for(block_t& block : blocks) {
+                ::operator delete(block.data);
+            }
+            blocks.clear();
+
+            add_block(total);
+        }
+
+        offset     = 0;
+        used_total = 0;
+    }
+
+    size_t frame_arena_t::capacity() const {
+        size_t total = 0;
+        for(const block_t& block : blocks) {
+            total += block.size;
+        }
+
+        return total;
+    }
+}
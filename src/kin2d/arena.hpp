@@ -0,0 +1,69 @@
+#pragma once
+
+#include "base.hpp"
+
+namespace kin {
+    // a bump allocator for memory that only has to live until the end of
+    // a world step. Nothing is freed individually, everything is released
+    // at once by reset()
+    class frame_arena_t {
+    public:
+        frame_arena_t(size_t initial_size = 64 * 1024);
+        ~frame_arena_t();
+
+        frame_arena_t(const frame_arena_t&) = delete;
+        frame_arena_t& operator=(const frame_arena_t&) = delete;
+
+        void* allocate(size_t size, size_t align);
+
+        // releases every allocation. If the arena had to grow during the last
+        // frame its blocks are merged into one large enough to hold all of it,
+        // so the next frame of the same size won't touch the heap
+        void reset();
+
+        // bytes handed out since the last reset
+        size_t used() const { return used_total; }
+        size_t capacity() const;
+
+    private:
+        struct block_t {
+            uint8_t* data;
+            size_t   size;
+        };
+
+        void add_block(size_t min_size);
+
+        std::vector<block_t> blocks;
+        size_t offset     = 0; // offset into the last block
+        size_t used_total = 0;
+    };
+
+    // allows STL containers to use a frame arena, deallocate is a no-op
+    template<typename T>
+    struct arena_allocator_t {
+        typedef T value_type;
+
+        arena_allocator_t(frame_arena_t& arena)
+            : arena(&arena) {}
+
+        template<typename U>
+        arena_allocator_t(const arena_allocator_t<U>& other)
+            : arena(other.arena) {}
+
+        T* allocate(size_t n) {
+            return (T*)arena->allocate(n * sizeof(T), alignof(T));
+        }
+
+        void deallocate(T*, size_t) {}
+
+        template<typename U>
+        bool operator==(const arena_allocator_t<U>& other) const { return arena == other.arena; }
+        template<typename U>
+        bool operator!=(const arena_allocator_t<U>& other) const { return arena != other.arena; }
+
+        frame_arena_t* arena;
+    };
+
+    template<typename T>
+    using frame_vector_t = std::vector<T, arena_allocator_t<T>>;
+}
@@ -4,6 +4,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtx/vector_angle.hpp>
 #include <chrono>
+#include <algorithm>
+#include <memory>
 #include <RTRee.h>
 
 namespace kin {
@@ -2,125 +2,186 @@
 #include "world.hpp"
 
 namespace kin {
-    rigid_body_t::rigid_body_t(world_t* world, glm::vec2 pos, float rot, body_type_t type)
-        : transform_t(pos, rot), world(world), type(type) {
+    rigid_body_t::rigid_body_t(world_t* world, body_store_t* store, glm::vec2 pos, float rot, body_type_t type)
+        : world(world), store(store), type(type) {
+        id = store->create(this, pos, rot);
 
         // sets all forces, velocities, and mass to zero
         set_zero();
     }
 
     rigid_body_t::~rigid_body_t() {
-        iterate_fixtures([&](fixture_t* fixture){
+        tile_grid.reset();
+
+        for_each_fixture([&](fixture_t* fixture){
             destroy_fixture(fixture);
         });
+
+        store->destroy(id);
     }
 
     void rigid_body_t::set_zero() {
+        const uint32_t i = index();
+
         inertia      = 0.0f;
-        invinertia   = 0.0f;
+        store->invinertia[i] = 0.0f;
         
         center_of_mass = {0.0f, 0.0f};
         mass        = 0.0f;
-        invmass     = 0.0f;
+        store->invmass[i] = 0.0f;
 
-        torque      = 0.0f;
-        angular_vel = 0.0f;
+        store->torque[i]      = 0.0f;
+        store->angular_vel[i] = 0.0f;
 
-        linear_vel  = {0.0f, 0.0f};
-        forces      = {0.0f, 0.0f};
+        store->linear_vel[i]  = {0.0f, 0.0f};
+        store->forces[i]      = {0.0f, 0.0f};
 
-        compute_sincos();
+        compute_motion();
     }
 
-    void rigid_body_t::update(float delta_time) {
-        if(is_static()) {
-            // we check this because I want to insure if the user
-            // ever switches the type of a body, it doesn't have a bunch
-            // of built up forces that havent been cleared
-            assert(forces.x == 0.0f && forces.y == 0.0f && torque == 0.0f);
-
-            return;
-        }   
-
-        {
-            linear_vel += delta_time * invmass * forces;
-
-            pos += linear_vel * delta_time;
-            forces   = {0.0f, 0.0f};
-        }
+    void rigid_body_t::set_rotation(float rot) {
+        const uint32_t i = index();
 
-        {
-            angular_vel += delta_time * invinertia * torque;
+        fast_sincos(rot, store->psin[i], store->pcos[i]);
+        on_teleport();
+    }
 
-            rot += angular_vel * delta_time;
-            torque = 0.0f;
+    void rigid_body_t::on_teleport() {
+        wake();
 
-            compute_sincos();
+        // dynamic proxies are updated by the next step, or by the next query if that comes first
+        if(!is_static()) {
+            world->proxies_stale = true;
+            return;
         }
-    }
 
-    void rigid_body_t::set_rotation(float rot) {
-        this->rot = rot;
-        compute_sincos();
+        for_each_fixture([&](fixture_t* fixture) {
+            fixture->update_vertices();
+            world->insert_proxy(fixture, {0.0f, 0.0f});
+        });
     }
 
     void rigid_body_t::apply_angular_velocity(float velocity) {
-        angular_vel += velocity * (float)type;
+        wake();
+
+        angular_vel() += velocity * (float)type;
     }
 
     void rigid_body_t::apply_linear_velocity(glm::vec2 velocity) {
-        linear_vel += velocity * (float)type;
+        wake();
+
+        linear_vel() += velocity * (float)type;
     }
 
     void rigid_body_t::apply_force(glm::vec2 force) {
-        forces += force * (float)type;
+        wake();
+
+        store->forces[index()] += force * (float)type;
     };
 
     void rigid_body_t::apply_force_at_point(glm::vec2 force, glm::vec2 point) {
-        forces += force * (float)type;
-        torque += cross(point, force) * (float)type;
+        wake();
+
+        const uint32_t i = index();
+
+        store->forces[i] += force * (float)type;
+        store->torque[i] += cross(point, force) * (float)type;
     }
 
     fixture_t* rigid_body_t::create_fixture(const fixture_def_t& def) {
         int relement = world->relement_pool.insert(rtree_element_t());
+        if((size_t)relement >= world->proxies.size()) {
+            world->proxies.resize(relement + 1);
+        }
+
         fixture_t* new_fixture = world->fixture_pool.create(1, this, relement, def);
 
-        world->root.insert(world->relement(relement));
+        world->insert_proxy(new_fixture, {0.0f, 0.0f});
+        wake();
 
         return new_fixture;
     }
 
+    void rigid_body_t::create_fixtures(const fixture_def_t* defs, uint32_t count, fixture_t** fixtures) {
+        if(count == 0)
+            return;
+
+        // the caller might already be inserting in bulk, e.g. world_t::create_rigid_bodies
+        const bool outer_bulk = world->bulk_inserting;
+        if(!outer_bulk) {
+            world->begin_bulk_insert();
+        }
+
+        fixture_t* first = nullptr;
+
+        defer_mass = true;
+        for(uint32_t i = 0; i < count; i++) {
+            fixture_t* fixture = create_fixture(defs[i]);
+            if(fixtures != nullptr) {
+                fixtures[i] = fixture;
+            }
+
+            if(i == 0) {
+                first = fixture;
+            }
+        }
+        defer_mass = false;
+
+        compute_mass();
+
+        // the fixtures were placed while the center of mass was still being summed up.
+        // New fixtures are at the front of the list, up to and including the first one
+        fixture_t* fixture = static_cast<fixture_t*>(this->fixtures.first);
+        while(fixture != nullptr) {
+            fixture->update_vertices();
+            world->compute_proxy_box(fixture, {0.0f, 0.0f});
+
+            if(fixture == first)
+                break;
+
+            fixture = static_cast<fixture_t*>(fixture->next);
+        }
+
+        if(!outer_bulk) {
+            world->end_bulk_insert();
+        }
+    }
+
     void rigid_body_t::destroy_fixture(fixture_t* fixture) {
-        world->root.remove(world->relement(fixture->relement_id));
+        // the grid would destroy it a second time
+        assert(!fixture->grid_owned);
+
+        world->remove_proxy(fixture);
         world->relement_pool.erase(fixture->relement_id);
         world->fixture_pool.destroy(fixture, 1);
+        wake();
     }
 
-    void rigid_body_t::iterate_fixtures(fixture_callback_t callback) {
-        fixture_t* fixture = dynamic_cast<fixture_t*>(fixtures.first);
-        while(fixture != nullptr) {
-            // in case of the callback destroying the fixture
-            // this prevents reading invalid memory compared to if we were 
-            // to instead do this: fixture = fixture->next
-            fixture_t* next = dynamic_cast<fixture_t*>(fixture->next);
+    tile_grid_t* rigid_body_t::create_tile_grid(const tile_grid_def_t& def) {
+        assert(tile_grid == nullptr);
 
-            callback(fixture);
+        tile_grid = std::make_unique<tile_grid_t>(this, def);
+        return tile_grid.get();
+    }
 
-            fixture = next;
-        }
+    void rigid_body_t::iterate_fixtures(fixture_callback_t callback) {
+        for_each_fixture(callback);
     }
 
     void rigid_body_t::add_mass(glm::vec2 rel_center, float add_mass, float add_tensor) {
+        world->topology_version++;
         total_center_of_mass += rel_center * add_mass;
         mass += add_mass;
-        compute_invmass();
-    
         inertia += add_tensor;
-        compute_invintertia();
-        compute_center_of_mass();
+
+        if(defer_mass)
+            return;
+
+        compute_mass();
     }
 
     void rigid_body_t::remove_mass(glm::vec2 rel_center, float rem_mass, float rem_tensor) {
+        world->topology_version++;
         total_center_of_mass -= rel_center * rem_mass;
         mass -= rem_mass;
         compute_invmass();
@@ -128,32 +189,40 @@ namespace kin {
         inertia -= rem_tensor;
         compute_invintertia();
         compute_center_of_mass();
+        compute_motion();
     }
 
-    void rigid_body_t::compute_sincos() {
-        psin = fast_sin(rot);
-        pcos = fast_cos(rot);
+    void rigid_body_t::compute_mass() {
+        compute_invmass();
+        compute_invintertia();
+        compute_center_of_mass();
+        compute_motion();
     }
 
     void rigid_body_t::compute_center_of_mass() {
-        center_of_mass = total_center_of_mass * invmass;
+        center_of_mass = total_center_of_mass * invmass();
     }
 
     void rigid_body_t::compute_invmass() {
-        if(is_static()) {
-            invmass = 0.0f;
+        // a body without any fixtures has no mass
+        if(is_static() || mass <= 0.0f) {
+            store->invmass[index()] = 0.0f;
             return;
         }
 
-        invmass = 1.0f / mass;
+        store->invmass[index()] = 1.0f / mass;
     }   
 
     void rigid_body_t::compute_invintertia() {
-        if(is_static()) {
-            invinertia = 0.0f;
+        if(is_static() || inertia <= 0.0f) {
+            store->invinertia[index()] = 0.0f;
             return;
         }
 
-        invinertia = 1.0f / inertia;
+        store->invinertia[index()] = 1.0f / inertia;
+    }
+
+    void rigid_body_t::compute_motion() {
+        store->motion[index()] = (!is_static() && mass > 0.0f) ? 1.0f : 0.0f;
     }
 }
\ No newline at end of file
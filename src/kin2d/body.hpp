@@ -1,6 +1,8 @@
 #pragma once
 
 #include "fixture.hpp"
+#include "tile_grid.hpp"
+#include "body_store.hpp"
 #include "math.hpp"
 
 namespace kin {
@@ -15,24 +17,58 @@ namespace kin {
 
     inline uint32_t body_count = 0;
 
-    struct rigid_body_t : public transform_t, public ptm::doubly_linked_list_element_t {
+    // everything needed to create a body along with its fixtures, see world_t::create_rigid_bodies
+    struct body_def_t {
+        glm::vec2   pos  = {0.0f, 0.0f};
+        float       rot  = 0.0f;
+        body_type_t type = body_type_dynamic;
+
+        const fixture_def_t* fixtures = nullptr;
+        uint32_t fixture_count = 0;
+    };
+
+    // a rigid body, the data used each step (position, rotation, velocities, inverse masses)
+    // lives in the world's body_store_t and is reached through the accessors below
+    struct rigid_body_t {
         friend class world_t;
         friend class fixture_t;
 
         rigid_body_t() { assert(false); }
-        rigid_body_t(world_t* world, glm::vec2 pos, float rot, body_type_t type);
+        rigid_body_t(world_t* world, body_store_t* store, glm::vec2 pos, float rot, body_type_t type);
         ~rigid_body_t();
 
-        void update(float delta_time);
+        glm::vec2& pos()         { return store->pos[index()]; }
+        glm::vec2  pos() const   { return store->pos[index()]; }
+        // the angle in (-pi, pi], worked out from the rotation each call. Prefer psin and pcos
+        float      rot() const   { return std::atan2(psin(), pcos()); }
+        glm::vec2& linear_vel()  { return store->linear_vel[index()]; }
+        float&     angular_vel() { return store->angular_vel[index()]; }
+        float      invmass() const    { return store->invmass[index()]; }
+        float      invinertia() const { return store->invinertia[index()]; }
+        float      psin() const  { return store->psin[index()]; }
+        float      pcos() const  { return store->pcos[index()]; }
+
+        bool is_awake() const { return store->awake[index()] != 0; }
+
+        // wakes the body and its island up if it is sleeping, and resets its sleep timer
+        void wake() { store->wake(id); }
+
+        // the index of this body in the body store, changes when other bodies are destroyed
+        uint32_t index() const { return store->index(id); }
+
+        glm::vec2 get_world_pos() const {
+            return pos() + center_of_mass;
+        }
 
-        glm::vec2 get_world_pos() const override {
-            return pos + center_of_mass;
+        float get_world_rot() const {
+            return rot();
         }
 
-        glm::vec2 get_world_point(glm::vec2 point) const override {
-            glm::vec2 rot_point = fast_rotate_w_precalc(point - center_of_mass, psin, pcos);
+        glm::vec2 get_world_point(glm::vec2 point) const {
+            const uint32_t i = index();
+            glm::vec2 rot_point = fast_rotate_w_precalc(point - center_of_mass, store->psin[i], store->pcos[i]);
 
-            return (rot_point + center_of_mass) + pos;
+            return (rot_point + center_of_mass) + store->pos[i];
         }
 
         // You must call this function when setting the rotation of the rigid body
@@ -43,55 +79,84 @@ namespace kin {
         void apply_force(glm::vec2 force);
         void apply_force_at_point(glm::vec2 force, glm::vec2 point);
         fixture_t* create_fixture(const fixture_def_t& def);
+        // creates count fixtures at once, the mass of the body is only computed once all of them 
+        // exist and dynamic fixtures go into the broadphase together. If fixtures is not null
+        // it receives the new fixtures in the order of defs
+        void       create_fixtures(const fixture_def_t* defs, uint32_t count, fixture_t** fixtures = nullptr);
+        // the fixtures of a tile grid can't be destroyed through here, clear their tiles instead
         void       destroy_fixture(fixture_t* fixture);
 
+        // gives the body a tile grid, the grid owns the fixtures it creates and is
+        // destroyed along with the body. A body can only have one tile grid
+        tile_grid_t* create_tile_grid(const tile_grid_def_t& def);
+        tile_grid_t* get_tile_grid() { return tile_grid.get(); }
+
         bool has_fixtures() { return !fixtures.is_empty(); }
         bool is_static() { return type == body_type_static; }
 
         void iterate_fixtures(fixture_callback_t fixture);
 
+        // same as iterate_fixtures, but the callback is called directly
+        // so it can be inlined. Prefer this in anything that runs every step
+        template<typename F>
+        void for_each_fixture(F&& callback) {
+            fixture_t* fixture = static_cast<fixture_t*>(fixtures.first);
+            while(fixture != nullptr) {
+                // in case of the callback destroying the fixture
+                fixture_t* next = static_cast<fixture_t*>(fixture->next);
+
+                callback(fixture);
+
+                fixture = next;
+            }
+        }
+
         void set_position(glm::vec2 pos) {
-            this->pos =  center_of_mass + pos;
+            this->pos() = center_of_mass + pos;
+            on_teleport();
         }
 
         void add_position(glm::vec2 add) {
-            this->pos += add;
+            this->pos() += add;
+            on_teleport();
         }
 
     public:
         body_type_t type = (body_type_t)ptm::blatent_i32;
 
         float     inertia      = ptm::blatent_f;
-        float     invinertia   = ptm::blatent_f;
         
         // the rotated center of mass
         glm::vec2 center_of_mass     = {ptm::blatent_f, ptm::blatent_f};
         float     mass        = ptm::blatent_f;
-        float     invmass     = ptm::blatent_f;
-
-        float     torque      = ptm::blatent_f;
-        float     angular_vel = ptm::blatent_f;
-
-        glm::vec2 linear_vel  = {ptm::blatent_f, ptm::blatent_f};
-        glm::vec2 forces      = {ptm::blatent_f, ptm::blatent_f};
 
         world_t* world = nullptr;
 
     protected:
-        float psin = ptm::blatent_f, pcos = ptm::blatent_f; // precalculated sin and cos
+        body_store_t* store = nullptr;
+        body_id_t     id    = (body_id_t)ptm::blatent_i32;
 
         ptm::doubly_linked_list_header_t<fixture_t> fixtures;
+        std::unique_ptr<tile_grid_t> tile_grid;
 
         // the center of mass with no average calculations applied
         glm::vec2 total_center_of_mass = {0.0f, 0.0f};
+        // while set, add_mass only sums up mass and compute_mass has to be called afterwards
+        bool      defer_mass = false;
 
         void add_mass(glm::vec2 rel_center, float mass, float tensor);
         void remove_mass(glm::vec2 rel_center, float mass, float tensor);
 
+        // wakes the body, static bodies aren't updated each step so their fixtures are 
+        // updated here. Dynamic bodies only tell the world to update them before a query
+        void on_teleport();
+
         void set_zero();
-        void compute_sincos();
+        // recomputes everything that depends on the mass of the body
+        void compute_mass();
         void compute_center_of_mass();
         void compute_invmass();
         void compute_invintertia();
+        void compute_motion();
     };
-}
\ No newline at end of file
+}
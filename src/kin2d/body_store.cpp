@@ -0,0 +1,106 @@
+#include "body_store.hpp"
+#include "math.hpp"
+
+namespace kin {
+    body_id_t body_store_t::create(rigid_body_t* body, glm::vec2 new_pos, float new_rot) {
+        body_id_t id;
+        if(!free_ids.empty()) {
+            id = free_ids.back();
+            free_ids.pop_back();
+        } else {
+            id = (body_id_t)sparse.size();
+            sparse.push_back(0);
+        }
+
+        sparse[id] = (uint32_t)bodies.size();
+
+        pos.push_back(new_pos);
+        float new_sin, new_cos;
+        fast_sincos(new_rot, new_sin, new_cos);
+        psin.push_back(new_sin);
+        pcos.push_back(new_cos);
+        linear_vel.push_back({0.0f, 0.0f});
+        angular_vel.push_back(0.0f);
+        forces.push_back({0.0f, 0.0f});
+        torque.push_back(0.0f);
+        invmass.push_back(0.0f);
+        invinertia.push_back(0.0f);
+        motion.push_back(0.0f);
+        awake.push_back(1);
+        sleep_time.push_back(0.0f);
+        island_next.push_back(id);
+        bodies.push_back(body);
+        ids.push_back(id);
+
+        return id;
+    }
+
+    void body_store_t::reserve(size_t count) {
+        const size_t capacity = bodies.size() + count;
+
+        pos.reserve(capacity);
+        psin.reserve(capacity);
+        pcos.reserve(capacity);
+        linear_vel.reserve(capacity);
+        angular_vel.reserve(capacity);
+        forces.reserve(capacity);
+        torque.reserve(capacity);
+        invmass.reserve(capacity);
+        invinertia.reserve(capacity);
+        motion.reserve(capacity);
+        awake.reserve(capacity);
+        sleep_time.reserve(capacity);
+        island_next.reserve(capacity);
+        bodies.reserve(capacity);
+        ids.reserve(capacity);
+        sparse.reserve(sparse.size() + (count > free_ids.size() ? count - free_ids.size() : 0));
+    }
+
+    void body_store_t::wake(body_id_t id) {
+        body_id_t cur = id;
+        do {
+            uint32_t i = sparse[cur];
+
+            awake[i]       = 1;
+            sleep_time[i]  = 0.0f;
+            cur            = island_next[i];
+            island_next[i] = ids[i];
+        } while(cur != id);
+    }
+
+    template<typename T>
+    static void swap_remove(std::vector<T>& array, uint32_t index) {
+        array[index] = array.back();
+        array.pop_back();
+    }
+
+    void body_store_t::destroy(body_id_t id) {
+        // a sleeping island can't have a hole in it
+        wake(id);
+
+        uint32_t index = sparse[id];
+
+        swap_remove(pos, index);
+        swap_remove(psin, index);
+        swap_remove(pcos, index);
+        swap_remove(linear_vel, index);
+        swap_remove(angular_vel, index);
+        swap_remove(forces, index);
+        swap_remove(torque, index);
+        swap_remove(invmass, index);
+        swap_remove(invinertia, index);
+        swap_remove(motion, index);
+        swap_remove(awake, index);
+        swap_remove(sleep_time, index);
+        swap_remove(island_next, index);
+        swap_remove(bodies, index);
+        swap_remove(ids, index);
+
+        // the last body now lives where the destroyed one was
+        if(index < ids.size()) {
+            sparse[ids[index]] = index;
+        }
+
+        free_ids.push_back(id);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "base.hpp"
+
+namespace kin {
+    struct rigid_body_t;
+
+    // a handle to a body inside of a body_store_t, it stays the same for the
+    // whole lifetime of the body even when its data is moved around
+    typedef uint32_t body_id_t;
+
+    // stores the data of every body that is touched each step as dense arrays,
+    // index i refers to the same body in every array. Destroying a body moves
+    // the last body into its slot, so indices are not stable but ids are
+    class body_store_t {
+    public:
+        body_id_t create(rigid_body_t* body, glm::vec2 pos, float rot);
+        void      destroy(body_id_t id);
+
+        // makes room for count more bodies in every array
+        void reserve(size_t count);
+
+        // wakes the body, and every other body in the island it fell asleep with
+        void wake(body_id_t id);
+
+        uint32_t index(body_id_t id) const { return sparse[id]; }
+        size_t   size() const { return bodies.size(); }
+
+    public:
+        std::vector<glm::vec2> pos;
+        // the rotation as the unit vector (cos, sin) rather than an angle,
+        // it is integrated as is so that stepping never needs sin or cos
+        std::vector<float>     psin;
+        std::vector<float>     pcos;
+        std::vector<glm::vec2> linear_vel;
+        std::vector<float>     angular_vel;
+        std::vector<glm::vec2> forces;
+        std::vector<float>     torque;
+        std::vector<float>     invmass;
+        std::vector<float>     invinertia;
+
+        // 1.0f if the body is integrated every step, 0.0f if not
+        // (static bodies, or bodies without any mass)
+        std::vector<float>     motion;
+
+        // sleeping bodies are not integrated, and neither are their fixtures updated
+        std::vector<uint8_t>   awake;
+        // how long the body has been resting for
+        std::vector<float>     sleep_time;
+        // the bodies of a sleeping island form a circular list through this,
+        // awake bodies point to themselves
+        std::vector<body_id_t> island_next;
+
+        std::vector<rigid_body_t*> bodies;
+        std::vector<body_id_t>     ids;
+
+    private:
+        std::vector<uint32_t>  sparse; // id -> index
+        std::vector<body_id_t> free_ids;
+    };
+}
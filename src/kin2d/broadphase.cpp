@@ -0,0 +1,592 @@
+#include "broadphase.hpp"
+#include "static_tree.hpp"
+#include <iterator>
+
+namespace kin {
+    std::unique_ptr<broadphase_t> create_broadphase(broadphase_type_t type, thread_pool_t* thread_pool) {
+        switch(type) {
+        case broadphase_type_sap:
+            return std::make_unique<sap_broadphase_t>();
+        case broadphase_type_grid:
+            return std::make_unique<grid_broadphase_t>(thread_pool);
+        case broadphase_type_rtree:
+        default:
+            return std::make_unique<rtree_broadphase_t>();
+        }
+    }
+
+    void broadphase_t::insert_bulk(const uint32_t* ids, const aabb_t* boxes, uint32_t count) {
+        for(uint32_t i = 0; i < count; i++) {
+            insert(ids[i], boxes[i]);
+        }
+    }
+
+    void rtree_broadphase_t::insert(uint32_t id, const aabb_t& aabb) {
+        if(id >= boxes.size()) {
+            boxes.resize(id + 1);
+            present.resize(id + 1, 0);
+        }
+
+        element_t element;
+        element.min[0] = aabb.min[0];
+        element.min[1] = aabb.min[1];
+        element.max[0] = aabb.max[0];
+        element.max[1] = aabb.max[1];
+        element.id     = id;
+
+        boxes[id]   = aabb;
+        present[id] = 1;
+        root.insert(element);
+        count++;
+    }
+
+    void rtree_broadphase_t::insert_bulk(const uint32_t* ids, const aabb_t* new_boxes, uint32_t new_count) {
+        uint32_t max_id = 0;
+        for(uint32_t i = 0; i < new_count; i++) {
+            max_id = std::max(max_id, ids[i]);
+        }
+
+        if(new_count != 0 && max_id >= boxes.size()) {
+            boxes.resize(max_id + 1);
+            present.resize(max_id + 1, 0);
+        }
+
+        // the tree splits nodes as it goes, so it ends up far tighter when neighbours are inserted
+        // together. Sort tile recursive order hands it one node's worth of neighbours at a time
+        std::vector<static_tree_t::entry_t> entries(new_count);
+        for(uint32_t i = 0; i < new_count; i++) {
+            entries[i].aabb = new_boxes[i];
+            entries[i].id   = ids[i];
+        }
+
+        sort_tile_recursive(entries, static_tree_t::node_size);
+
+        std::vector<element_t> elements(new_count);
+        for(uint32_t i = 0; i < new_count; i++) {
+            element_t& element = elements[i];
+            element.min[0] = entries[i].aabb.min[0];
+            element.min[1] = entries[i].aabb.min[1];
+            element.max[0] = entries[i].aabb.max[0];
+            element.max[1] = entries[i].aabb.max[1];
+            element.id     = entries[i].id;
+
+            boxes[element.id]   = entries[i].aabb;
+            present[element.id] = 1;
+        }
+
+        root.insert(elements.begin(), elements.end());
+        count += new_count;
+    }
+
+    void rtree_broadphase_t::remove(uint32_t id) {
+        element_t element;
+        element.min[0] = boxes[id].min[0];
+        element.min[1] = boxes[id].min[1];
+        element.max[0] = boxes[id].max[0];
+        element.max[1] = boxes[id].max[1];
+        element.id     = id;
+
+        root.remove(element);
+        present[id] = 0;
+        count--;
+    }
+
+    // an output iterator that hands every element the tree finds straight to the callback,
+    // so that a query doesn't need a results buffer and can run on several threads at once
+    struct query_output_t {
+        typedef std::output_iterator_tag iterator_category;
+        typedef void value_type;
+        typedef void difference_type;
+        typedef void pointer;
+        typedef void reference;
+
+        broadphase_query_fn_t fn;
+        void* context;
+
+        query_output_t& operator*() { return *this; }
+        query_output_t& operator++() { return *this; }
+        query_output_t  operator++(int) { return *this; }
+
+        template<typename E>
+        query_output_t& operator=(const E& element) {
+            fn(context, element.id);
+            return *this;
+        }
+    };
+
+    void rtree_broadphase_t::query_prepared(const aabb_t& aabb, broadphase_query_fn_t fn, void* context) const {
+        root.query(spatial::intersects<2>(aabb.min, aabb.max), query_output_t{fn, context});
+    }
+
+    void rtree_broadphase_t::find_pairs(const uint8_t* active, broadphase_pair_fn_t fn, void* context) {
+        for(uint32_t id = 0; id < boxes.size(); id++) {
+            if(!active[id] || !present[id])
+                continue;
+
+            const aabb_t& aabb = boxes[id];
+
+            results.clear();
+            root.query(spatial::intersects<2>(aabb.min, aabb.max), std::back_inserter(results));
+
+            for(const element_t& element : results) {
+                // two active proxies find each other, only the lower id reports the pair
+                if(element.id == id || (active[element.id] && element.id < id))
+                    continue;
+
+                fn(context, id, element.id);
+            }
+        }
+    }
+
+    void sap_broadphase_t::insert(uint32_t id, const aabb_t& aabb) {
+        if(id >= boxes.size()) {
+            boxes.resize(id + 1);
+            present.resize(id + 1, 0);
+            in_order.resize(id + 1, 0);
+        }
+
+        boxes[id]   = aabb;
+        present[id] = 1;
+        count++;
+
+        // a proxy that is reinserted before the array was prepared keeps its slot
+        if(in_order[id]) {
+            removed--;
+            return;
+        }
+
+        in_order[id] = 1;
+        order.push_back(id);
+        appended++;
+    }
+
+    void sap_broadphase_t::remove(uint32_t id) {
+        present[id] = 0;
+        count--;
+        removed++;
+    }
+
+    void sap_broadphase_t::prepare() {
+        if(removed != 0) {
+            order.erase(std::remove_if(order.begin(), order.end(), [&](uint32_t id) {
+                if(present[id])
+                    return false;
+
+                in_order[id] = 0;
+                return true;
+            }), order.end());
+
+            removed = 0;
+        }
+
+        auto less = [&](uint32_t a, uint32_t b) {
+            return boxes[a].min[0] < boxes[b].min[0];
+        };
+
+        // a lot of new proxies would make the insertion sort quadratic
+        if(appended > 64 && appended * 8 > order.size()) {
+            std::sort(order.begin(), order.end(), less);
+        } else {
+            for(size_t i = 1; i < order.size(); i++) {
+                const uint32_t id = order[i];
+
+                size_t j = i;
+                while(j > 0 && less(id, order[j - 1])) {
+                    order[j] = order[j - 1];
+                    j--;
+                }
+
+                order[j] = id;
+            }
+        }
+
+        appended  = 0;
+        max_width = 0.0f;
+        for(uint32_t id : order) {
+            max_width = std::max(max_width, boxes[id].max[0] - boxes[id].min[0]);
+        }
+    }
+
+    void sap_broadphase_t::query_prepared(const aabb_t& aabb, broadphase_query_fn_t fn, void* context) const {
+        // nothing that starts further left than the widest box can reach aabb
+        const float first_min = aabb.min[0] - max_width;
+        auto first = std::lower_bound(order.begin(), order.end(), first_min, [&](uint32_t id, float x) {
+            return boxes[id].min[0] < x;
+        });
+
+        for(auto it = first; it != order.end(); ++it) {
+            const aabb_t& other = boxes[*it];
+            if(other.min[0] > aabb.max[0])
+                break;
+
+            if(aabb_collide(aabb, other)) {
+                fn(context, *it);
+            }
+        }
+    }
+
+    void sap_broadphase_t::find_pairs(const uint8_t* active, broadphase_pair_fn_t fn, void* context) {
+        prepare();
+
+        for(size_t i = 0; i < order.size(); i++) {
+            const uint32_t id1 = order[i];
+            const aabb_t&  box1 = boxes[id1];
+
+            for(size_t j = i + 1; j < order.size(); j++) {
+                const uint32_t id2 = order[j];
+                const aabb_t&  box2 = boxes[id2];
+
+                if(box2.min[0] > box1.max[0])
+                    break;
+
+                if(!active[id1] && !active[id2])
+                    continue;
+
+                if(box1.min[1] <= box2.max[1] && box2.min[1] <= box1.max[1]) {
+                    fn(context, id1, id2);
+                }
+            }
+        }
+    }
+
+    static uint32_t hash_cell(int32_t x, int32_t y) {
+        return ((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u);
+    }
+
+    static bool boxes_overlap(const aabb_t& a, const aabb_t& b) {
+        return a.min[0] <= b.max[0] && b.min[0] <= a.max[0] &&
+               a.min[1] <= b.max[1] && b.min[1] <= a.max[1];
+    }
+
+    grid_broadphase_t::grid_broadphase_t(thread_pool_t* thread_pool, float cell_size, uint32_t max_cells)
+        : thread_pool(thread_pool), cell_size(cell_size), inv_cell_size(1.0f / cell_size), max_cells(max_cells) {
+        assert(cell_size > 0.0f);
+        table.resize(64, 0);
+    }
+
+    grid_broadphase_t::cell_range_t grid_broadphase_t::compute_range(const aabb_t& aabb) const {
+        return {
+            (int32_t)std::floor(aabb.min[0] * inv_cell_size),
+            (int32_t)std::floor(aabb.min[1] * inv_cell_size),
+            (int32_t)std::floor(aabb.max[0] * inv_cell_size),
+            (int32_t)std::floor(aabb.max[1] * inv_cell_size)
+        };
+    }
+
+    bool grid_broadphase_t::is_oversized(const cell_range_t& range) const {
+        const uint64_t width  = (uint64_t)((int64_t)range.x1 - range.x0 + 1);
+        const uint64_t height = (uint64_t)((int64_t)range.y1 - range.y0 + 1);
+
+        return width * height > max_cells;
+    }
+
+    void grid_broadphase_t::insert(uint32_t id, const aabb_t& aabb) {
+        if(id >= proxies.size()) {
+            proxies.resize(id + 1);
+        }
+
+        proxy_t& proxy = proxies[id];
+        const cell_range_t range = compute_range(aabb);
+
+        proxy.aabb    = aabb;
+        proxy.present = true;
+        count++;
+
+        // still listed in the same cells from before it was removed, nothing else has to change
+        if(proxy.listed && proxy.range == range)
+            return;
+
+        proxy.range = range;
+        proxy.moved = true;
+        dirty = true;
+    }
+
+    void grid_broadphase_t::remove(uint32_t id) {
+        proxies[id].present = false;
+        removed.push_back(id);
+        count--;
+    }
+
+    void grid_broadphase_t::flush() {
+        for(uint32_t id : removed) {
+            if(!proxies[id].present && proxies[id].listed) {
+                dirty = true;
+            }
+        }
+
+        removed.clear();
+
+        if(dirty) {
+            rebuild();
+        }
+    }
+
+    void grid_broadphase_t::rebuild() {
+        size_t empty = 0;
+        for(const cell_t& cell : cells) {
+            empty += cell.begin == cell.end ? 1 : 0;
+        }
+
+        if(empty > 64 && empty * 2 > cells.size()) {
+            compact_cells();
+        }
+
+        // counts the ids of every cell in end
+        for(cell_t& cell : cells) {
+            cell.end = 0;
+        }
+
+        oversized.clear();
+        next_entry_cells.clear();
+
+        for(uint32_t id = 0; id < proxies.size(); id++) {
+            proxy_t& proxy = proxies[id];
+            proxy.listed = proxy.present;
+
+            if(!proxy.present)
+                continue;
+
+            proxy.oversize = is_oversized(proxy.range);
+            if(proxy.oversize) {
+                oversized.push_back(id);
+                proxy.moved = false;
+                continue;
+            }
+
+            const uint32_t first = (uint32_t)next_entry_cells.size();
+
+            if(proxy.moved) {
+                for(int32_t y = proxy.range.y0; y <= proxy.range.y1; y++) {
+                    for(int32_t x = proxy.range.x0; x <= proxy.range.x1; x++) {
+                        next_entry_cells.push_back(find_or_create_cell(x, y));
+                    }
+                }
+            } else {
+                const uint32_t area = (uint32_t)((proxy.range.x1 - proxy.range.x0 + 1) * (proxy.range.y1 - proxy.range.y0 + 1));
+                next_entry_cells.insert(next_entry_cells.end(), entry_cells.begin() + proxy.first_entry, entry_cells.begin() + proxy.first_entry + area);
+            }
+
+            for(size_t i = first; i < next_entry_cells.size(); i++) {
+                cells[next_entry_cells[i]].end++;
+            }
+
+            proxy.first_entry = first;
+            proxy.moved = false;
+        }
+
+        entry_cells.swap(next_entry_cells);
+
+        uint32_t offset = 0;
+        for(cell_t& cell : cells) {
+            cell.begin = offset;
+            offset    += cell.end;
+            cell.end   = cell.begin;
+        }
+
+        // the ids go in the same order they were counted in, so every cell lists its ids sorted
+        cell_ids.resize(offset);
+
+        size_t entry = 0;
+        for(uint32_t id = 0; id < proxies.size(); id++) {
+            const proxy_t& proxy = proxies[id];
+            if(!proxy.present || proxy.oversize)
+                continue;
+
+            const uint32_t area = (uint32_t)((proxy.range.x1 - proxy.range.x0 + 1) * (proxy.range.y1 - proxy.range.y0 + 1));
+            for(uint32_t i = 0; i < area; i++) {
+                cell_ids[cells[entry_cells[entry++]].end++] = id;
+            }
+        }
+
+        dirty = false;
+    }
+
+    void grid_broadphase_t::compact_cells() {
+        cells.erase(std::remove_if(cells.begin(), cells.end(), [](const cell_t& cell) {
+            return cell.begin == cell.end;
+        }), cells.end());
+
+        std::fill(table.begin(), table.end(), 0);
+
+        const uint32_t mask = (uint32_t)table.size() - 1;
+        for(uint32_t i = 0; i < cells.size(); i++) {
+            uint32_t slot = hash_cell(cells[i].x, cells[i].y) & mask;
+            while(table[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+
+            table[slot] = i + 1;
+        }
+
+        for(proxy_t& proxy : proxies) {
+            proxy.moved = true;
+        }
+    }
+
+    uint32_t grid_broadphase_t::find_cell(int32_t x, int32_t y) const {
+        const uint32_t mask = (uint32_t)table.size() - 1;
+
+        for(uint32_t slot = hash_cell(x, y) & mask; table[slot] != 0; slot = (slot + 1) & mask) {
+            const cell_t& cell = cells[table[slot] - 1];
+            if(cell.x == x && cell.y == y)
+                return table[slot] - 1;
+        }
+
+        return UINT32_MAX;
+    }
+
+    uint32_t grid_broadphase_t::find_or_create_cell(int32_t x, int32_t y) {
+        uint32_t index = find_cell(x, y);
+        if(index != UINT32_MAX)
+            return index;
+
+        // the table keeps its size between rebuilds, so it only 
+        // allocates when there are more cells than ever before
+        if((cells.size() + 1) * 2 > table.size()) {
+            table.assign(table.size() * 2, 0);
+
+            const uint32_t mask = (uint32_t)table.size() - 1;
+            for(uint32_t i = 0; i < cells.size(); i++) {
+                uint32_t slot = hash_cell(cells[i].x, cells[i].y) & mask;
+                while(table[slot] != 0) {
+                    slot = (slot + 1) & mask;
+                }
+
+                table[slot] = i + 1;
+            }
+        }
+
+        const uint32_t mask = (uint32_t)table.size() - 1;
+        uint32_t slot = hash_cell(x, y) & mask;
+        while(table[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+
+        index = (uint32_t)cells.size();
+        table[slot] = index + 1;
+        cells.push_back({x, y, 0, 0});
+
+        return index;
+    }
+
+    void grid_broadphase_t::query_prepared(const aabb_t& aabb, broadphase_query_fn_t fn, void* context) const {
+        const cell_range_t range = compute_range(aabb);
+
+        if(is_oversized(range)) {
+            for(uint32_t id = 0; id < proxies.size(); id++) {
+                if(proxies[id].listed && !proxies[id].oversize && boxes_overlap(aabb, proxies[id].aabb)) {
+                    fn(context, id);
+                }
+            }
+        } else {
+            for(int32_t y = range.y0; y <= range.y1; y++) {
+                for(int32_t x = range.x0; x <= range.x1; x++) {
+                    const uint32_t index = find_cell(x, y);
+                    if(index == UINT32_MAX)
+                        continue;
+
+                    const cell_t& cell = cells[index];
+                    for(uint32_t i = cell.begin; i < cell.end; i++) {
+                        const uint32_t id = cell_ids[i];
+                        const proxy_t& proxy = proxies[id];
+
+                        // a proxy in several of the cells is only reported 
+                        // by the first cell both ranges share
+                        if(std::max(proxy.range.x0, range.x0) != x || std::max(proxy.range.y0, range.y0) != y)
+                            continue;
+
+                        if(boxes_overlap(aabb, proxy.aabb)) {
+                            fn(context, id);
+                        }
+                    }
+                }
+            }
+        }
+
+        for(uint32_t id : oversized) {
+            if(boxes_overlap(aabb, proxies[id].aabb)) {
+                fn(context, id);
+            }
+        }
+    }
+
+    void grid_broadphase_t::find_pairs(const uint8_t* active, broadphase_pair_fn_t fn, void* context) {
+        flush();
+
+        const uint32_t thread_count = thread_pool ? thread_pool->thread_count() : 1;
+        if(thread_pairs.size() < thread_count) {
+            thread_pairs.resize(thread_count);
+        }
+
+        for(auto& pairs : thread_pairs) {
+            pairs.clear();
+        }
+
+        auto find_cell_pairs = [&](uint32_t begin, uint32_t end, uint32_t thread_index) {
+            std::vector<std::pair<uint32_t, uint32_t>>& pairs = thread_pairs[thread_index];
+
+            for(uint32_t c = begin; c < end; c++) {
+                const cell_t& cell = cells[c];
+
+                for(uint32_t i = cell.begin; i < cell.end; i++) {
+                    const uint32_t id1 = cell_ids[i];
+                    const proxy_t& proxy1 = proxies[id1];
+
+                    for(uint32_t j = i + 1; j < cell.end; j++) {
+                        const uint32_t id2 = cell_ids[j];
+                        const proxy_t& proxy2 = proxies[id2];
+
+                        if(!active[id1] && !active[id2])
+                            continue;
+
+                        // proxies sharing several cells are only paired in the first one
+                        if(std::max(proxy1.range.x0, proxy2.range.x0) != cell.x || std::max(proxy1.range.y0, proxy2.range.y0) != cell.y)
+                            continue;
+
+                        if(boxes_overlap(proxy1.aabb, proxy2.aabb)) {
+                            pairs.emplace_back(id1, id2);
+                        }
+                    }
+                }
+            }
+        };
+
+        if(thread_pool) {
+            thread_pool->parallel_for((uint32_t)cells.size(), 64, find_cell_pairs);
+        } else {
+            find_cell_pairs(0, (uint32_t)cells.size(), 0);
+        }
+
+        for(const auto& pairs : thread_pairs) {
+            for(const auto& pair : pairs) {
+                fn(context, pair.first, pair.second);
+            }
+        }
+
+        // the few oversized proxies are tested against everything
+        for(size_t i = 0; i < oversized.size(); i++) {
+            const uint32_t id1 = oversized[i];
+            const proxy_t& proxy1 = proxies[id1];
+
+            for(uint32_t id2 = 0; id2 < proxies.size(); id2++) {
+                const proxy_t& proxy2 = proxies[id2];
+
+                // pairs of two oversized proxies are found below
+                if(!proxy2.listed || proxy2.oversize)
+                    continue;
+
+                if((active[id1] || active[id2]) && boxes_overlap(proxy1.aabb, proxy2.aabb)) {
+                    fn(context, id1, id2);
+                }
+            }
+
+            for(size_t j = i + 1; j < oversized.size(); j++) {
+                const uint32_t id2 = oversized[j];
+
+                if((active[id1] || active[id2]) && boxes_overlap(proxy1.aabb, proxies[id2].aabb)) {
+                    fn(context, id1, id2);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include "aabb.hpp"
+#include "thread_pool.hpp"
+#include "settings.hpp"
+
+namespace kin {
+    enum broadphase_type_t: int {
+        broadphase_type_rtree = 0,
+        // sweep and prune along the x axis, best for long levels with coherent motion
+        broadphase_type_sap   = 1,
+        // a uniform grid, best when most fixtures are boxes of about the same size
+        broadphase_type_grid  = 2
+    };
+
+    typedef void(*broadphase_query_fn_t)(void* context, uint32_t id);
+    typedef void(*broadphase_pair_fn_t)(void* context, uint32_t id1, uint32_t id2);
+
+    // the structure the world keeps its dynamic proxies in. Proxies are identified by 
+    // their relement id, the boxes given to the broadphase are the fattened boxes; when 
+    // to fatten and reinsert is up to the world. Callbacks are function pointers with a 
+    // context, so that a query never allocates
+    class broadphase_t {
+    public:
+        virtual ~broadphase_t() = default;
+
+        virtual void insert(uint32_t id, const aabb_t& aabb) = 0;
+        virtual void remove(uint32_t id) = 0;
+
+        // the same as calling insert for each of the count proxies, which is what it does unless
+        // a backend overrides it to pick a better order or to size its arrays only once
+        virtual void insert_bulk(const uint32_t* ids, const aabb_t* boxes, uint32_t count);
+
+        // calls fn for every proxy whose box overlaps aabb
+        void query(const aabb_t& aabb, broadphase_query_fn_t fn, void* context) {
+            prepare_queries();
+            query_prepared(aabb, fn, context);
+        }
+
+        // applies any work the backend put off until the next query. After this and up to
+        // the next insert or remove, query_prepared only reads and can run on several threads
+        virtual void prepare_queries() {}
+        virtual void query_prepared(const aabb_t& aabb, broadphase_query_fn_t fn, void* context) const = 0;
+
+        // calls fn exactly once for every pair of overlapping proxies where at least one of 
+        // the two has a nonzero active[id]. fn is always called from the calling thread
+        virtual void find_pairs(const uint8_t* active, broadphase_pair_fn_t fn, void* context) = 0;
+
+        virtual size_t size() const = 0;
+        virtual broadphase_type_t type() const = 0;
+        // false if settings the backend copied when it was created have changed since
+        virtual bool uses_current_settings() const { return true; }
+
+        // query with any callable, callback(id)
+        template<typename F>
+        void for_each_overlap(const aabb_t& aabb, F&& callback) {
+            typedef std::remove_reference_t<F> fn_t;
+
+            query(aabb, [](void* context, uint32_t id) {
+                (*(fn_t*)context)(id);
+            }, (void*)std::addressof(callback));
+        }
+
+        // query_prepared with any callable, callback(id)
+        template<typename F>
+        void for_each_overlap_prepared(const aabb_t& aabb, F&& callback) const {
+            typedef std::remove_reference_t<F> fn_t;
+
+            query_prepared(aabb, [](void* context, uint32_t id) {
+                (*(fn_t*)context)(id);
+            }, (void*)std::addressof(callback));
+        }
+
+        // find_pairs with any callable, callback(id1, id2)
+        template<typename F>
+        void for_each_pair(const uint8_t* active, F&& callback) {
+            typedef std::remove_reference_t<F> fn_t;
+
+            find_pairs(active, [](void* context, uint32_t id1, uint32_t id2) {
+                (*(fn_t*)context)(id1, id2);
+            }, (void*)std::addressof(callback));
+        }
+    };
+
+    // backends that can split up their work use thread_pool, it may be null
+    std::unique_ptr<broadphase_t> create_broadphase(broadphase_type_t type, thread_pool_t* thread_pool = nullptr);
+
+    // the dynamic R-tree the world has always used
+    class rtree_broadphase_t : public broadphase_t {
+    public:
+        void insert(uint32_t id, const aabb_t& aabb) override;
+        // the tree has no packed build, so this still inserts one element at a time. It only 
+        // sorts them with sort_tile_recursive first so that neighbours end up in the same nodes
+        void insert_bulk(const uint32_t* ids, const aabb_t* boxes, uint32_t count) override;
+        void remove(uint32_t id) override;
+        void query_prepared(const aabb_t& aabb, broadphase_query_fn_t fn, void* context) const override;
+        void find_pairs(const uint8_t* active, broadphase_pair_fn_t fn, void* context) override;
+
+        size_t size() const override { return count; }
+        broadphase_type_t type() const override { return broadphase_type_rtree; }
+
+    private:
+        struct element_t : aabb_t {
+            uint32_t id;
+
+            bool operator==(const element_t& other) const {
+                return id == other.id;
+            }
+        };
+
+        spatial::RTree<float, element_t, 2> root;
+        // the box every proxy was inserted with, the tree needs it to remove the proxy
+        std::vector<aabb_t>    boxes;
+        std::vector<uint8_t>   present;
+        std::vector<element_t> results;
+        size_t count = 0;
+    };
+
+    // keeps every proxy in one array sorted by the minimum x of its box. Motion is 
+    // mostly coherent, so an insertion sort puts the array back in order in close to linear time
+    class sap_broadphase_t : public broadphase_t {
+    public:
+        void insert(uint32_t id, const aabb_t& aabb) override;
+        void remove(uint32_t id) override;
+        void query_prepared(const aabb_t& aabb, broadphase_query_fn_t fn, void* context) const override;
+        void find_pairs(const uint8_t* active, broadphase_pair_fn_t fn, void* context) override;
+
+        size_t size() const override { return count; }
+        broadphase_type_t type() const override { return broadphase_type_sap; }
+
+        void prepare_queries() override { prepare(); }
+
+    private:
+        // drops removed proxies and sorts the array
+        void prepare();
+
+        std::vector<aabb_t>   boxes;
+        // whether the id is currently in the broadphase
+        std::vector<uint8_t>  present;
+        // whether the id has a slot in order, removed ids keep theirs until the next prepare
+        std::vector<uint8_t>  in_order;
+        std::vector<uint32_t> order;
+
+        size_t count    = 0;
+        size_t removed  = 0;
+        // proxies added to the end of order since the last prepare
+        size_t appended = 0;
+        // the widest box, bounds how far back a query has to look
+        float  max_width = 0.0f;
+    };
+
+    // a spatial hash of uniform cells, each proxy is listed in every cell its box covers. 
+    // The cells are rebuilt with a counting sort whenever a proxy changes cells, into arrays 
+    // that keep their capacity, and reinserting a proxy whose box still covers the same cells 
+    // only updates the box. Pairs are generated cell by cell across the thread pool. Proxies 
+    // covering more than max_cells cells are kept in a list and tested against every other 
+    // proxy, so each of them adds the cost of a pass over all proxies to find_pairs
+    class grid_broadphase_t : public broadphase_t {
+    public:
+        grid_broadphase_t(thread_pool_t* thread_pool, float cell_size = settings.grid_cell_size, uint32_t max_cells = settings.grid_max_cells);
+
+        void insert(uint32_t id, const aabb_t& aabb) override;
+        void remove(uint32_t id) override;
+        void query_prepared(const aabb_t& aabb, broadphase_query_fn_t fn, void* context) const override;
+        void find_pairs(const uint8_t* active, broadphase_pair_fn_t fn, void* context) override;
+
+        size_t size() const override { return count; }
+        broadphase_type_t type() const override { return broadphase_type_grid; }
+        bool uses_current_settings() const override { 
+            return cell_size == settings.grid_cell_size && max_cells == settings.grid_max_cells; 
+        }
+
+        void prepare_queries() override { flush(); }
+
+    private:
+        struct cell_range_t {
+            int32_t x0, y0, x1, y1;
+
+            bool operator==(const cell_range_t& other) const {
+                return x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1;
+            }
+        };
+
+        struct proxy_t {
+            aabb_t       aabb;
+            cell_range_t range;
+            // whether the id is currently in the broadphase
+            bool present  = false;
+            // whether the id is listed in the cells of range (or in oversized), removed
+            // proxies stay listed until the next rebuild in case they are reinserted
+            bool listed   = false;
+            bool oversize = false;
+            // whether range changed since the last rebuild, if not its cells are 
+            // still entry_cells[first_entry, first_entry + the cell count of range)
+            bool moved    = true;
+            uint32_t first_entry = 0;
+        };
+
+        struct cell_t {
+            int32_t x, y;
+            // the ids listed in this cell are cell_ids[begin, end)
+            uint32_t begin, end;
+        };
+
+        cell_range_t compute_range(const aabb_t& aabb) const;
+        bool is_oversized(const cell_range_t& range) const;
+
+        // rebuilds the cells if a proxy was added, removed or changed cells since the last time
+        void flush();
+        void rebuild();
+        // drops the cells that were left empty, every proxy has to look its cells up again after
+        void compact_cells();
+
+        uint32_t find_cell(int32_t x, int32_t y) const;
+        uint32_t find_or_create_cell(int32_t x, int32_t y);
+
+        thread_pool_t* thread_pool;
+        float    cell_size;
+        float    inv_cell_size;
+        uint32_t max_cells;
+
+        std::vector<proxy_t>  proxies;
+        std::vector<uint32_t> removed;
+        std::vector<uint32_t> oversized;
+
+        // cells stay in place across rebuilds and are only dropped by compact_cells
+        std::vector<cell_t>   cells;
+        // the ids of every cell, grouped by cell
+        std::vector<uint32_t> cell_ids;
+        // the cell of every id in cell_ids in proxy order, and the same built by the next rebuild
+        std::vector<uint32_t> entry_cells;
+        std::vector<uint32_t> next_entry_cells;
+        // open addressing, holds the cell index plus one, 0 for an empty slot. Only ever grows
+        std::vector<uint32_t> table;
+        bool dirty = false;
+
+        // pairs found by each thread
+        std::vector<std::vector<std::pair<uint32_t, uint32_t>>> thread_pairs;
+
+        size_t count = 0;
+    };
+}
@@ -2,50 +2,60 @@
 #include "world.hpp"
 
 namespace kin {
-    bool solve_collision_if_there(fixture_t& fix1, fixture_t& fix2, collision_manifold_t& manifold) {
-        rigid_body_t& body1 = *fix1.body;
-        rigid_body_t& body2 = *fix2.body;
-        world_t* world = body1.world;
+    // how far correct_positions moves each body
+    static void get_corrections(bool static1, bool static2, const collision_manifold_t& manifold, glm::vec2& move1, glm::vec2& move2) {
+        // speculative contacts have a negative depth and aren't corrected
+        const glm::vec2 amount = manifold.depth > 0.0f ? (manifold.normal * manifold.depth) * 0.5f : glm::vec2(0.0f);
 
-        if(!aabb_collide(world->relement(fix1.relement_id), world->relement(fix2.relement_id)))
-            return false;
-        
-        if(!sat_test(fix1, fix2, manifold))
+        move1 = static1 ? glm::vec2(0.0f) : -amount;
+        move2 = static2 ? glm::vec2(0.0f) :  amount;
+    }
+
+    bool speculative_collide(const fixture_t& fix1, const fixture_t& fix2, 
+        const collision_proxy_t& proxy1, const collision_proxy_t& proxy2, glm::vec2 relative_vel, float step, collision_manifold_t& manifold) {
+        glm::vec2 normal;
+        const float separation = sat_separation(proxy1, proxy2, normal);
+
+        // how far the boxes close in on each other along the normal this step
+        const float approach = glm::max(0.0f, -glm::dot(relative_vel, normal)) * step;
+        if(separation > approach + settings.speculative_distance)
             return false;
 
-        const glm::vec2 amount = (manifold.normal * manifold.depth) * 0.5f;
-
-        if(body1.is_static())  {
-            body2.pos += amount;   
-        
-            body2.iterate_fixtures([=](fixture_t* fixture){
-                fixture->update_vertices();
-            });
-        } else if(body2.is_static()) {
-            body1.pos -= amount;
-
-            body1.iterate_fixtures([=](fixture_t* fixture){
-                fixture->update_vertices();
-            });
-        } else {
-            body1.pos -= amount;
-            body2.pos += amount;   
-        
-            body1.iterate_fixtures([=](fixture_t* fixture){
-                fixture->update_vertices();
-            });
-
-            body2.iterate_fixtures([=](fixture_t* fixture){
-                fixture->update_vertices();
-            });
+        manifold.normal = normal;
+        manifold.depth  = -separation;
+        compute_contact(fix1, fix2, proxy1, proxy2, manifold);
+
+        return true;
+    }
+
+    void compute_contact(const fixture_t& fix1, const fixture_t& fix2, 
+        const collision_proxy_t& proxy1, const collision_proxy_t& proxy2, collision_manifold_t& manifold) {
+        // the contact points are found as if correct_positions 
+        // had already pushed the bodies apart
+        glm::vec2 move1, move2;
+        get_corrections(fix1.body->is_static(), fix2.body->is_static(), manifold, move1, move2);
+
+        collision_proxy_t separated1 = proxy1;
+        collision_proxy_t separated2 = proxy2;
+        for(int i = 0; i < 4; i++) {
+            separated1.world_vertices[i] += move1;
+            separated2.world_vertices[i] += move2;
         }
 
-        compute_manifold(fix1, fix2, manifold);
+        compute_manifold(separated1, separated2, manifold);
 
         manifold.restitution = glm::max(fix1.restitution, fix2.restitution);
         manifold.static_friction = (fix1.static_friction + fix2.static_friction) * 0.5f;
         manifold.dynamic_friction = (fix1.dynamic_friction + fix2.dynamic_friction) * 0.5f;
+    }
 
-        return true;
+    void correct_positions(rigid_body_t& body1, rigid_body_t& body2, const collision_manifold_t& manifold, float share1, float share2) {
+        glm::vec2 move1, move2;
+        get_corrections(body1.is_static(), body2.is_static(), manifold, move1, move2);
+
+        // the fixtures are not updated here, that happens for every 
+        // awake body before the broadphase runs
+        body1.pos() += move1 * share1;
+        body2.pos() += move2 * share2;
     }
-}
\ No newline at end of file
+}
@@ -3,9 +3,18 @@
 #include "body.hpp"
 
 namespace kin {
+    // identifies which vertex and edge produced a contact point, so that
+    // the same point can be recognized from one step to the next
+    typedef uint8_t contact_feature_t;
+
+    inline contact_feature_t make_contact_feature(uint32_t flip, uint32_t vertex, uint32_t edge) {
+        return (contact_feature_t)((flip << 4) | (vertex << 2) | edge);
+    }
+
     struct collision_manifold_t {
         uint8_t                  count = 0;
         std::array<glm::vec2, 2> points = {};
+        std::array<contact_feature_t, 2> features = {};
  
         glm::vec2 normal = {0.0f, 0.0f};
         float     depth = 0.0f;
@@ -14,9 +23,10 @@ namespace kin {
         float static_friction;                      
         float dynamic_friction;
 
-        void add(glm::vec2 point) {
+        void add(glm::vec2 point, contact_feature_t feature) {
             if(count != points.size()) {
                 points[count] = point;
+                features[count] = feature;
                 count++;
             }
         }
@@ -79,7 +89,7 @@ namespace kin {
     }
 
     // uses the seperating axis theorem test to see if two shapes are collding
-    inline bool sat_test(obb_t& obb1, obb_t& obb2, collision_manifold_t& manifold) {
+    inline bool sat_test(const collision_proxy_t& obb1, const collision_proxy_t& obb2, collision_manifold_t& manifold) {
         manifold.depth = std::numeric_limits<float>::max();
         manifold.normal = {0.0f, 0.0f};
 
@@ -94,6 +104,30 @@ namespace kin {
         return true;
     }
 
+    // the largest gap between two seperated boxes along any of their axes, normal is set to 
+    // that axis pointing from obb1 to obb2. Negative if the boxes overlap on every axis
+    inline float sat_separation(const collision_proxy_t& obb1, const collision_proxy_t& obb2, glm::vec2& normal) {
+        const glm::vec2 axes[4] = {obb1.normals[0], obb1.normals[1], obb2.normals[0], obb2.normals[1]};
+        float separation = -std::numeric_limits<float>::max();
+
+        for(glm::vec2 axis : axes) {
+            min_max_t shape1 = project_vertices(obb1.world_vertices, axis);
+            min_max_t shape2 = project_vertices(obb2.world_vertices, axis);
+
+            if(shape2.min - shape1.max > separation) {
+                separation = shape2.min - shape1.max;
+                normal = axis;
+            }
+
+            if(shape1.min - shape2.max > separation) {
+                separation = shape1.min - shape2.max;
+                normal = -axis;
+            }
+        }
+
+        return separation;
+    }
+
     inline float point_segment_distance(glm::vec2 p, glm::vec2 v1, glm::vec2 v2, glm::vec2& cp) {
         // credit goes to https://www.youtube.com/watch?v=egmZJU-1zPU&ab_channel=Two-BitCoding
         // for this function, incredible channel and resource
@@ -116,8 +150,10 @@ namespace kin {
         return glm::distance(p, cp);
     }
 
-    // finds the closest point on points1 to one of points2's edges
+    // finds the closest point on points1 to one of points2's edges, flip tells the features which 
+    // of the two boxes points1 belongs to. Points within tolerance of the closest one are a second contact
     inline void find_closest_points(glm::vec2& cp1, glm::vec2& cp2, uint32_t& count, float& distance1, 
+        contact_feature_t& feature1, contact_feature_t& feature2, uint32_t flip, float tolerance,
         const box_vertices_t& points1, const box_vertices_t& points2) {
         for(uint32_t i = 0; i < points1.size(); i++) {
             glm::vec2 p = points1[i];
@@ -129,14 +165,16 @@ namespace kin {
                 glm::vec2 cp;
                 float distance = point_segment_distance(p, prev, cur, cp);
 
-                if(nearly_equal(distance, distance1, 0.1f)) {
+                if(nearly_equal(distance, distance1, tolerance)) {
                     if(!nearly_equal(cp, cp1, 0.005f)) {
                         count = 2;
                         cp2 = cp;
+                        feature2 = make_contact_feature(flip, i, j);
                     }
                 } else if(distance <= distance1) {
                     count = 1;
                     cp1 = cp;
+                    feature1 = make_contact_feature(flip, i, j);
                     distance1 = distance;
                 }
             }
@@ -144,26 +182,44 @@ namespace kin {
     }
 
     // computes the collision manifold between two OBBs
-    inline void compute_manifold(obb_t& obb1, obb_t& obb2, collision_manifold_t& manifold) {
+    inline void compute_manifold(const collision_proxy_t& obb1, const collision_proxy_t& obb2, collision_manifold_t& manifold) {
         float min_distance = std::numeric_limits<float>::max();
         uint32_t count = 0;
         glm::vec2 min_cp;
         glm::vec2 min_cp2;
+        contact_feature_t feature1 = 0;
+        contact_feature_t feature2 = 0;
+
+        // thin boxes would otherwise pick up a point on their far edge
+        const float thinnest = std::min(
+            std::min(glm::distance(obb1.world_vertices[0], obb1.world_vertices[1]), glm::distance(obb1.world_vertices[0], obb1.world_vertices[3])),
+            std::min(glm::distance(obb2.world_vertices[0], obb2.world_vertices[1]), glm::distance(obb2.world_vertices[0], obb2.world_vertices[3])));
+        const float tolerance = std::min(0.1f, thinnest * 0.25f);
 
-        find_closest_points(min_cp, min_cp2, count, min_distance, obb1.world_vertices, obb2.world_vertices);
-        find_closest_points(min_cp, min_cp2, count, min_distance, obb2.world_vertices, obb1.world_vertices);
+        find_closest_points(min_cp, min_cp2, count, min_distance, feature1, feature2, 0, tolerance, obb1.world_vertices, obb2.world_vertices);
+        find_closest_points(min_cp, min_cp2, count, min_distance, feature1, feature2, 1, tolerance, obb2.world_vertices, obb1.world_vertices);
 
         assert(count != 0);
 
-        manifold.add(min_cp);
+        manifold.add(min_cp, feature1);
         if(count == 2) {
-            manifold.add(min_cp2);
+            manifold.add(min_cp2, feature2);
         }
     }
 
-    // solves a collision between two fixtures if they are intersecting, returns found
-    // results to collision manifold. Does NOT solve impulses
-    bool solve_collision_if_there(fixture_t& fix1, fixture_t& fix2, collision_manifold_t& manifold);
+    // finishes a collision once the seperating axis test has filled the manifold's normal and depth,
+    // finds the contact points and mixes the fixtures' materials
+    void compute_contact(const fixture_t& fix1, const fixture_t& fix2, 
+        const collision_proxy_t& proxy1, const collision_proxy_t& proxy2, collision_manifold_t& manifold);
+
+    // fills the manifold with a speculative contact if two seperated fixtures are less than reach apart.
+    // The manifold's depth is set to minus the gap, which the solver lets the bodies close but no more
+    bool speculative_collide(const fixture_t& fix1, const fixture_t& fix2, 
+        const collision_proxy_t& proxy1, const collision_proxy_t& proxy2, glm::vec2 relative_vel, float step, collision_manifold_t& manifold);
+
+    // pushes two colliding bodies apart along the manifold's normal, each by share of its half 
+    // of the depth. Does NOT solve impulses
+    void correct_positions(rigid_body_t& body1, rigid_body_t& body2, const collision_manifold_t& manifold, float share1 = 1.0f, float share2 = 1.0f);
     
     struct impulse_t {
         glm::vec2 r1;
@@ -173,7 +229,7 @@ namespace kin {
     };
 
     // solve for new velocties for two bodies given a collision manifodl
-    inline void impulse_method(rigid_body_t& body1, rigid_body_t& body2, collision_manifold_t& manifold) {
+    inline void impulse_method(rigid_body_t& body1, rigid_body_t& body2, const collision_manifold_t& manifold) {
         impulse_t impulse;
         glm::vec2 average = manifold.points[0];
 
@@ -189,12 +245,12 @@ namespace kin {
             glm::vec2 r1_perp = {impulse.r1.y, -impulse.r1.x};
             glm::vec2 r2_perp = {impulse.r2.y, -impulse.r2.x};
 
-            glm::vec2 angular_linear1 = r1_perp * body1.angular_vel;
-            glm::vec2 angular_linear2 = r2_perp * body2.angular_vel;
+            glm::vec2 angular_linear1 = r1_perp * body1.angular_vel();
+            glm::vec2 angular_linear2 = r2_perp * body2.angular_vel();
 
             glm::vec2 rel_vel = 
-                (body2.linear_vel + angular_linear2) - 
-                (body1.linear_vel + angular_linear1);
+                (body2.linear_vel() + angular_linear2) - 
+                (body1.linear_vel() + angular_linear1);
 
             float rel_vel_dot_n = glm::dot(rel_vel, manifold.normal);
             if(rel_vel_dot_n > 0.0f)
@@ -204,9 +260,9 @@ namespace kin {
             float r2_perp_dot_n = glm::dot(r2_perp, manifold.normal);
 
             float denom = 
-                body1.invmass + body2.invmass + 
-                (sqaure(r1_perp_dot_n) * body1.invinertia) + 
-                (sqaure(r2_perp_dot_n) * body2.invinertia);
+                body1.invmass() + body2.invmass() + 
+                (sqaure(r1_perp_dot_n) * body1.invinertia()) + 
+                (sqaure(r2_perp_dot_n) * body2.invinertia());
             
             impulse.j = -(1.0f + manifold.restitution) * rel_vel_dot_n;
             impulse.j /= denom;
@@ -215,21 +271,27 @@ namespace kin {
             // apply impulse
             glm::vec2 impulsej = impulse.j * manifold.normal;
 
-            body1.linear_vel  -= impulsej * body1.invmass;
-            body1.angular_vel -= cross(impulsej, impulse.r1) * body1.invinertia;
-            body2.linear_vel  += impulsej * body2.invmass;
-            body2.angular_vel += cross(impulsej, impulse.r2) * body2.invinertia;
+            // static bodies are never written to, other contacts 
+            // with the same static body may be solved on other threads
+            if(!body1.is_static()) {
+                body1.linear_vel()  -= impulsej * body1.invmass();
+                body1.angular_vel() -= cross(impulsej, impulse.r1) * body1.invinertia();
+            }
+            if(!body2.is_static()) {
+                body2.linear_vel()  += impulsej * body2.invmass();
+                body2.angular_vel() += cross(impulsej, impulse.r2) * body2.invinertia();
+            }
         }
 
         { // tangent calculations
             glm::vec2 r1_perp = {impulse.r1.y, -impulse.r1.x};
             glm::vec2 r2_perp = {impulse.r2.y, -impulse.r2.x};
 
-            glm::vec2 angular_linear1 = r1_perp * body1.angular_vel;
-            glm::vec2 angular_linear2 = r2_perp * body2.angular_vel;
+            glm::vec2 angular_linear1 = r1_perp * body1.angular_vel();
+            glm::vec2 angular_linear2 = r2_perp * body2.angular_vel();
 
             glm::vec2 rel_vel = 
-                (body2.linear_vel + angular_linear2) - (body1.linear_vel + angular_linear1);
+                (body2.linear_vel() + angular_linear2) - (body1.linear_vel() + angular_linear1);
 
             glm::vec2 tangent = rel_vel - glm::dot(rel_vel, manifold.normal) * manifold.normal;
             if(nearly_equal(tangent, {0.0f, 0.0f}))
@@ -241,9 +303,9 @@ namespace kin {
             float r2_perp_dot_t = glm::dot(r2_perp, tangent);
 
             float denom = 
-                body1.invmass + body2.invmass + 
-               (sqaure(r1_perp_dot_t) * body1.invinertia) + 
-               (sqaure(r2_perp_dot_t) * body2.invinertia);
+                body1.invmass() + body2.invmass() + 
+               (sqaure(r1_perp_dot_t) * body1.invinertia()) + 
+               (sqaure(r2_perp_dot_t) * body2.invinertia());
 
             float jt = -glm::dot(rel_vel, tangent);
             jt /= denom;
@@ -255,11 +317,15 @@ namespace kin {
                 impulse.friction_impulse = -impulse.j * tangent * manifold.dynamic_friction;
             }
 
-            body1.linear_vel -= impulse.friction_impulse * body1.invmass;
-            body1.angular_vel -= cross(impulse.friction_impulse, impulse.r1) * body1.invinertia;
+            if(!body1.is_static()) {
+                body1.linear_vel() -= impulse.friction_impulse * body1.invmass();
+                body1.angular_vel() -= cross(impulse.friction_impulse, impulse.r1) * body1.invinertia();
+            }
 
-            body2.linear_vel += impulse.friction_impulse * body2.invmass;
-            body2.angular_vel += cross(impulse.friction_impulse, impulse.r2) * body2.invinertia;
+            if(!body2.is_static()) {
+                body2.linear_vel() += impulse.friction_impulse * body2.invmass();
+                body2.angular_vel() += cross(impulse.friction_impulse, impulse.r2) * body2.invinertia();
+            }
         }
     }
 }
\ No newline at end of file
@@ -40,7 +40,7 @@ namespace kin {
     }
 
     glm::vec2 fixture_t::get_world_pos() const {
-        return body->get_world_pos() + fast_rotate(pos - body->center_of_mass, body->rot);
+        return body->get_world_pos() + fast_rotate_w_precalc(pos - body->center_of_mass, body->psin(), body->pcos());
     }
 
     float fixture_t::get_world_rot() const {
@@ -55,32 +55,34 @@ namespace kin {
             glm::vec2(-hw,  hh)
         };
 
-        normals[0] = fast_rotate_w_precalc(glm::vec2(-1.0f, 0.0f ), body->psin, body->pcos);
-        normals[1] = fast_rotate_w_precalc(glm::vec2( 0.0f, -1.0f), body->psin, body->pcos);
+        collision_proxy_t& proxy = body->world->proxy(relement_id);
+        box_vertices_t& world_vertices = proxy.world_vertices;
+        aabb_t& aabb = proxy.aabb;
 
-        rtree_element_t& relement = body->world->relement(relement_id);
+        proxy.normals[0] = fast_rotate_w_precalc(glm::vec2(-1.0f, 0.0f ), body->psin(), body->pcos());
+        proxy.normals[1] = fast_rotate_w_precalc(glm::vec2( 0.0f, -1.0f), body->psin(), body->pcos());
 
-        relement.min[0] = float_max;
-        relement.min[1] = float_max;
+        aabb.min[0] = float_max;
+        aabb.min[1] = float_max;
         
-        relement.max[0] = float_min;
-        relement.max[1] = float_min;
+        aabb.max[0] = -float_max;
+        aabb.max[1] = -float_max;
 
         for(int i = 0; i < 4; i++) {
             // the shape should be rotated by its relative position and the bodies center of mass
             world_vertices[i] = body->get_world_point(local_vertices[i] + pos);
 
-            if(world_vertices[i].x < relement.min[0]) {
-                relement.min[0] = world_vertices[i].x;
+            if(world_vertices[i].x < aabb.min[0]) {
+                aabb.min[0] = world_vertices[i].x;
             }
-            if(world_vertices[i].x >  relement.max[0]) {
-                relement.max[0] = world_vertices[i].x;
+            if(world_vertices[i].x > aabb.max[0]) {
+                aabb.max[0] = world_vertices[i].x;
             }
-            if(world_vertices[i].y < relement.min[1]) {
-                relement.min[1] = world_vertices[i].y;
+            if(world_vertices[i].y < aabb.min[1]) {
+                aabb.min[1] = world_vertices[i].y;
             }
-            if(world_vertices[i].y > relement.max[1]) {
-                relement.max[1] = world_vertices[i].y;
+            if(world_vertices[i].y > aabb.max[1]) {
+                aabb.max[1] = world_vertices[i].y;
             }
         }
     }
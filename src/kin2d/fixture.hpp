@@ -20,9 +20,11 @@ namespace kin {
 
         // del_mass_from_body is for internal use only, do not override
         void set_density(float density, bool del_mass_from_body = true);
-        virtual glm::vec2 get_local_pos() const override { return pos; }
-        virtual glm::vec2 get_world_pos() const override;
-        virtual float     get_world_rot() const override;
+        glm::vec2 get_local_pos() const { return pos; }
+        glm::vec2 get_world_pos() const;
+        float     get_world_rot() const;
+
+        // recomputes the collision proxy (vertices, normals and box) of this fixture
         void update_vertices();
 
         float tensor           = ptm::blatent_f;
@@ -31,9 +33,11 @@ namespace kin {
         float density          = ptm::blatent_f;
         float static_friction  = ptm::blatent_f;
         float dynamic_friction = ptm::blatent_f;
-        int   qt_id            = ptm::blatent_i32;
 
         rigid_body_t* body;
+        // also the index of this fixture's collision proxy
         int relement_id;
+        // set on the fixtures of a tile grid, only the grid may destroy them
+        bool grid_owned = false;
     };
 }
\ No newline at end of file
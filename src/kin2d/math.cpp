@@ -1,5 +1,16 @@
 #include "math.hpp"
 
 namespace kin {
-    
-}
\ No newline at end of file
+    void fast_sincos(const float* x, float* sin, float* cos, uint32_t count) {
+        for(uint32_t i = 0; i < count; i++) {
+            fast_sincos_unchecked(x[i], sin[i], cos[i]);
+        }
+
+        for(uint32_t i = 0; i < count; i++) {
+            if(!(std::abs(x[i]) <= fast_sincos_range)) {
+                sin[i] = std::sin(x[i]);
+                cos[i] = std::cos(x[i]);
+            }
+        }
+    }
+}
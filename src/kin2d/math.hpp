@@ -1,6 +1,8 @@
 #pragma once
 
 #include "base.hpp"
+#include <cmath>
+#include <cstring>
 
 namespace kin {
     inline float min(float x, float y) {
@@ -11,18 +13,74 @@ namespace kin {
         }
     }
 
+    // the range reduction of fast_sincos only holds up to here
+    constexpr float fast_sincos_range = 8192.0f;
+
+    // sin and cos of x without any calls or branches, so loops over it vectorize. x is brought into
+    // [-pi/4, pi/4] in three steps, then sin and cos come from minimax polynomials over that range.
+    // The absolute error is below 1e-7, about one ulp of 1, for |x| <= fast_sincos_range. Past 
+    // that the quadrant loses precision and the result is meaningless, though any x is safe to pass
+    inline void fast_sincos_unchecked(float x, float& sin, float& cos) {
+        // pi / 2 split into three floats, the first two have few enough 
+        // bits that multiplying them by the quadrant is exact
+        constexpr float pio2_1 = 1.5703125f;
+        constexpr float pio2_2 = 4.837512969970703125e-4f;
+        constexpr float pio2_3 = 7.54978995489188216e-8f;
+        constexpr float two_over_pi = 0.636619772367581343f;
+
+        // adding 1.5 * 2^23 rounds to the nearest quadrant and leaves it in the low bits of the 
+        // mantissa. Unlike a conversion to int this is defined for any x, inf and NaN included
+        constexpr float round_magic = 12582912.0f;
+        const float    shifted  = x * two_over_pi + round_magic;
+        const float    quadrant = shifted - round_magic;
+        const float    r  = ((x - quadrant * pio2_1) - quadrant * pio2_2) - quadrant * pio2_3;
+        const float    r2 = r * r;
+
+        uint32_t q;
+        std::memcpy(&q, &shifted, sizeof(q));
+
+        const float s = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+        const float c = 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+
+        // every quadrant swaps sin and cos and negates one of them
+        const bool  swap = (q & 1) != 0;
+        const float swapped_sin = swap ? c : s;
+        const float swapped_cos = swap ? s : c;
+        sin = (q & 2) != 0 ? -swapped_sin : swapped_sin;
+        cos = ((q + 1) & 2) != 0 ? -swapped_cos : swapped_cos;
+    }
+
+    // fast_sincos_unchecked for |x| <= fast_sincos_range, std::sin and std::cos 
+    // for anything else, infinities and NaN included
+    inline void fast_sincos(float x, float& sin, float& cos) {
+        if(std::abs(x) <= fast_sincos_range) {
+            fast_sincos_unchecked(x, sin, cos);
+        } else {
+            sin = std::sin(x);
+            cos = std::cos(x);
+        }
+    }
+
+    // fast_sincos of count angles. fast_sincos_unchecked runs over every angle in a loop 
+    // that vectorizes, then a second pass redoes the angles out of range
+    void fast_sincos(const float* x, float* sin, float* cos, uint32_t count);
+
     inline float fast_sin(float x){
-        return std::sin(x);
+        float sin, cos;
+        fast_sincos(x, sin, cos);
+        return sin;
     }
 
     inline float fast_cos(float x){
-        return std::cos(x);
+        float sin, cos;
+        fast_sincos(x, sin, cos);
+        return cos;
     }
 
     inline glm::vec2 fast_rotate(glm::vec2 v, float a) {
         glm::vec2 result;
-		const float cos = fast_cos(a);
-		const float sin = fast_sin(a);
+		float cos, sin;
+		fast_sincos(a, sin, cos);
 
 		result.x = v.x * cos - v.y * sin;
 		result.y = v.x * sin + v.y * cos;
@@ -7,12 +7,10 @@ namespace kin {
         transform_t();
         transform_t(glm::vec2 pos, float rot);
 
-        virtual ~transform_t() = default;
-
-        virtual glm::vec2 get_world_point(glm::vec2 point) const;
-        virtual glm::vec2 get_world_pos() const { return pos; }
-        virtual glm::vec2 get_local_pos() const { return pos; }
-        virtual float     get_world_rot() const { return rot; }
+        glm::vec2 get_world_point(glm::vec2 point) const;
+        glm::vec2 get_world_pos() const { return pos; }
+        glm::vec2 get_local_pos() const { return pos; }
+        float     get_world_rot() const { return rot; }
 
         glm::vec2 pos;
         float     rot;
@@ -28,16 +26,27 @@ namespace kin {
     public: 
         float hw;
         float hh; 
+    };
 
+    // everything narrowphase needs to know about a fixture, kept 
+    // in its own array so that iterating pairs touches one cache line per fixture
+    struct alignas(64) collision_proxy_t {
         box_vertices_t world_vertices;
-        box_normals_t normals;
+        box_normals_t  normals;
+
+        // the tight fitting box of world_vertices
+        aabb_t aabb;
     };
 
+    static_assert(sizeof(collision_proxy_t) == 64, "collision_proxy_t should fill exactly one cache line");
+
+    // the element stored in the broadphase, its box is the fattened
+    // box of the fixture and not the tight fitting one
     struct rtree_element_t : aabb_t {
         obb_t* obb;
 
         bool operator==(const rtree_element_t& other) {
-            return obb = other.obb;
+            return obb == other.obb;
         }
     };
 }
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include "world.hpp"
+
+namespace kin {
+    // calls callback(id) for every static and dynamic proxy whose broadphase box overlaps aabb.
+    // Only reads, so any number of threads can do this at once between world_t::prepare_queries and the next change
+    template<typename F>
+    static void for_each_candidate(const static_tree_t& static_tree, const broadphase_t& broadphase, const aabb_t& aabb, F&& callback) {
+        static_tree.query(aabb, callback);
+        broadphase.for_each_overlap_prepared(aabb, callback);
+    }
+
+    // min and max of the fixture projected onto axis
+    static void project(const collision_proxy_t& proxy, glm::vec2 axis, float& min, float& max) {
+        min = max = glm::dot(proxy.world_vertices[0], axis);
+
+        for(int i = 1; i < 4; i++) {
+            const float d = glm::dot(proxy.world_vertices[i], axis);
+            min = std::min(min, d);
+            max = std::max(max, d);
+        }
+    }
+
+    static bool overlaps(const aabb_t& aabb, const collision_proxy_t& proxy) {
+        // the tight box covers the world axes, which leaves the two axes of the fixture
+        if(!aabb_collide(aabb, proxy.aabb))
+            return false;
+
+        const glm::vec2 corners[4] = {
+            {aabb.min[0], aabb.min[1]}, {aabb.max[0], aabb.min[1]},
+            {aabb.max[0], aabb.max[1]}, {aabb.min[0], aabb.max[1]}
+        };
+
+        for(int axis = 0; axis < 2; axis++) {
+            const glm::vec2 normal = proxy.normals[axis];
+
+            float min, max;
+            project(proxy, normal, min, max);
+
+            float corner_min = glm::dot(corners[0], normal);
+            float corner_max = corner_min;
+            for(int i = 1; i < 4; i++) {
+                const float d = glm::dot(corners[i], normal);
+                corner_min = std::min(corner_min, d);
+                corner_max = std::max(corner_max, d);
+            }
+
+            if(corner_max < min || max < corner_min)
+                return false;
+        }
+
+        return true;
+    }
+
+    static bool contains(const collision_proxy_t& proxy, glm::vec2 point) {
+        for(int axis = 0; axis < 2; axis++) {
+            float min, max;
+            project(proxy, proxy.normals[axis], min, max);
+
+            const float d = glm::dot(point, proxy.normals[axis]);
+            if(d < min || d > max)
+                return false;
+        }
+
+        return true;
+    }
+
+    // slab test along both axes of the fixture. Rays that start inside the fixture don't hit it
+    static bool raycast(const ray_t& ray, const collision_proxy_t& proxy, float& fraction, glm::vec2& normal) {
+        float enter = -float_max;
+        float exit  = 1.0f;
+
+        for(int axis = 0; axis < 2; axis++) {
+            const glm::vec2 axis_normal = proxy.normals[axis];
+
+            float min, max;
+            project(proxy, axis_normal, min, max);
+
+            const float origin    = glm::dot(ray.origin, axis_normal);
+            const float direction = glm::dot(ray.translation, axis_normal);
+
+            // parallel to the faces, so it either always is between them or never is
+            if(std::abs(direction) < 1e-12f) {
+                if(origin < min || origin > max)
+                    return false;
+
+                continue;
+            }
+
+            // going up the axis the ray comes in through the face at min, whose normal points down the axis
+            const float inv_direction = 1.0f / direction;
+            const float t_min = (min - origin) * inv_direction;
+            const float t_max = (max - origin) * inv_direction;
+            const float t_enter = std::min(t_min, t_max);
+            const float t_exit  = std::max(t_min, t_max);
+
+            if(t_enter > enter) {
+                enter  = t_enter;
+                normal = direction > 0.0f ? -axis_normal : axis_normal;
+            }
+
+            exit = std::min(exit, t_exit);
+            if(enter > exit)
+                return false;
+        }
+
+        if(enter < 0.0f)
+            return false;
+
+        fraction = enter;
+        return true;
+    }
+
+    static aabb_t ray_aabb(const ray_t& ray) {
+        const glm::vec2 end = ray.origin + ray.translation;
+
+        return {
+            {std::min(ray.origin.x, end.x), std::min(ray.origin.y, end.y)},
+            {std::max(ray.origin.x, end.x), std::max(ray.origin.y, end.y)}
+        };
+    }
+
+    // adds fixture to the results of one query, kept sorted by id.
+    // Once results is full only fixtures with a lower id than the last one get in
+    static void add_result(fixture_t** results, uint32_t max_results, uint32_t& count, fixture_t* fixture) {
+        uint32_t i = std::min(count, max_results);
+        count++;
+
+        if(i == max_results) {
+            if(max_results == 0 || results[i - 1]->relement_id < fixture->relement_id)
+                return;
+
+            i--;
+        }
+
+        for(; i > 0 && results[i - 1]->relement_id > fixture->relement_id; i--) {
+            results[i] = results[i - 1];
+        }
+
+        results[i] = fixture;
+    }
+
+    // ordered by fraction first and fixture id second, so results never depend on the broadphase
+    static bool is_closer(const raycast_hit_t& a, const raycast_hit_t& b) {
+        if(a.fraction != b.fraction)
+            return a.fraction < b.fraction;
+
+        return a.fixture->relement_id < b.fixture->relement_id;
+    }
+
+    void world_t::prepare_queries() {
+        if(static_tree_dirty) {
+            build_static_tree();
+        }
+
+        if(proxies_stale) {
+            refresh_proxies();
+        }
+
+        broadphase->prepare_queries();
+    }
+
+    void world_t::query_aabbs(const aabb_t* boxes, uint32_t count, fixture_t** results, uint32_t max_results, uint32_t* counts) {
+        prepare_queries();
+
+        thread_pool.parallel_for(count, 32, [&](uint32_t begin, uint32_t end, uint32_t) {
+            for(uint32_t i = begin; i < end; i++) {
+                fixture_t** query_results = results + (size_t)i * max_results;
+                uint32_t found = 0;
+
+                for_each_candidate(static_tree, *broadphase, boxes[i], [&](uint32_t id) {
+                    if(overlaps(boxes[i], proxies[id])) {
+                        add_result(query_results, max_results, found, (fixture_t*)relement_pool[id].obb);
+                    }
+                });
+
+                counts[i] = found;
+            }
+        });
+    }
+
+    void world_t::query_points(const glm::vec2* points, uint32_t count, fixture_t** results, uint32_t max_results, uint32_t* counts) {
+        prepare_queries();
+
+        thread_pool.parallel_for(count, 32, [&](uint32_t begin, uint32_t end, uint32_t) {
+            for(uint32_t i = begin; i < end; i++) {
+                fixture_t** query_results = results + (size_t)i * max_results;
+                uint32_t found = 0;
+
+                const aabb_t aabb = {{points[i].x, points[i].y}, {points[i].x, points[i].y}};
+                for_each_candidate(static_tree, *broadphase, aabb, [&](uint32_t id) {
+                    if(contains(proxies[id], points[i])) {
+                        add_result(query_results, max_results, found, (fixture_t*)relement_pool[id].obb);
+                    }
+                });
+
+                counts[i] = found;
+            }
+        });
+    }
+
+    void world_t::raycast_closest(const ray_t* rays, uint32_t count, raycast_hit_t* hits) {
+        prepare_queries();
+
+        thread_pool.parallel_for(count, 32, [&](uint32_t begin, uint32_t end, uint32_t) {
+            for(uint32_t i = begin; i < end; i++) {
+                raycast_hit_t closest;
+
+                for_each_candidate(static_tree, *broadphase, ray_aabb(rays[i]), [&](uint32_t id) {
+                    raycast_hit_t hit;
+                    if(!raycast(rays[i], proxies[id], hit.fraction, hit.normal))
+                        return;
+
+                    hit.fixture = (fixture_t*)relement_pool[id].obb;
+                    if(closest.fixture == nullptr || is_closer(hit, closest)) {
+                        closest = hit;
+                    }
+                });
+
+                if(closest.fixture != nullptr) {
+                    closest.point = rays[i].origin + rays[i].translation * closest.fraction;
+                }
+
+                hits[i] = closest;
+            }
+        });
+    }
+
+    void world_t::raycast_all(const ray_t* rays, uint32_t count, raycast_hit_t* hits, uint32_t max_hits, uint32_t* counts) {
+        prepare_queries();
+
+        thread_pool.parallel_for(count, 32, [&](uint32_t begin, uint32_t end, uint32_t) {
+            for(uint32_t i = begin; i < end; i++) {
+                raycast_hit_t* ray_hits = hits + (size_t)i * max_hits;
+                uint32_t found = 0;
+
+                for_each_candidate(static_tree, *broadphase, ray_aabb(rays[i]), [&](uint32_t id) {
+                    raycast_hit_t hit;
+                    if(!raycast(rays[i], proxies[id], hit.fraction, hit.normal))
+                        return;
+
+                    hit.fixture = (fixture_t*)relement_pool[id].obb;
+                    hit.point   = rays[i].origin + rays[i].translation * hit.fraction;
+
+                    // same as add_result, but the closest hits are kept
+                    uint32_t slot = std::min(found, max_hits);
+                    found++;
+
+                    if(slot == max_hits) {
+                        if(max_hits == 0 || !is_closer(hit, ray_hits[slot - 1]))
+                            return;
+
+                        slot--;
+                    }
+
+                    for(; slot > 0 && is_closer(hit, ray_hits[slot - 1]); slot--) {
+                        ray_hits[slot] = ray_hits[slot - 1];
+                    }
+
+                    ray_hits[slot] = hit;
+                });
+
+                counts[i] = found;
+            }
+        });
+    }
+}
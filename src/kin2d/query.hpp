@@ -0,0 +1,23 @@
+#pragma once
+
+#include "base.hpp"
+
+namespace kin {
+    struct fixture_t;
+
+    // the segment from origin to origin + translation
+    struct ray_t {
+        glm::vec2 origin;
+        glm::vec2 translation;
+    };
+
+    struct raycast_hit_t {
+        // null if the ray hit nothing
+        fixture_t* fixture = nullptr;
+        glm::vec2  point   = {0.0f, 0.0f};
+        // the normal of the face that was hit
+        glm::vec2  normal  = {0.0f, 0.0f};
+        // how far along the ray the hit is, 0 at the origin and 1 at the end
+        float      fraction = 1.0f;
+    };
+}
@@ -0,0 +1,195 @@
+#include "sat_batch.hpp"
+
+namespace kin {
+    // every kernel follows sat_test: project both boxes onto the 4 axes, a lane misses
+    // as soon as one axis seperates them, otherwise the axis with the least overlap is kept.
+    // min and max are written out as comparisons in the same order as sat_test and 
+    // the x86 min/max instructions, that is what keeps every kernel identical
+
+    static void sat_test_batch_scalar(const sat_batch_t& batch, uint32_t count, sat_batch_result_t& result) {
+        for(uint32_t lane = 0; lane < count; lane++) {
+            float depth = float_max;
+            float normal_x = 0.0f;
+            float normal_y = 0.0f;
+            bool  hit = true;
+
+            for(int axis = 0; axis < 4 && hit; axis++) {
+                const float ax = batch.nx[axis][lane];
+                const float ay = batch.ny[axis][lane];
+
+                float min1 = batch.x1[0][lane] * ax + batch.y1[0][lane] * ay;
+                float min2 = batch.x2[0][lane] * ax + batch.y2[0][lane] * ay;
+                float max1 = min1;
+                float max2 = min2;
+
+                for(int i = 1; i < 4; i++) {
+                    const float p1 = batch.x1[i][lane] * ax + batch.y1[i][lane] * ay;
+                    const float p2 = batch.x2[i][lane] * ax + batch.y2[i][lane] * ay;
+
+                    min1 = p1 < min1 ? p1 : min1;
+                    max1 = p1 > max1 ? p1 : max1;
+                    min2 = p2 < min2 ? p2 : min2;
+                    max2 = p2 > max2 ? p2 : max2;
+                }
+
+                hit = max1 >= min2 && max2 >= min1;
+
+                const float overlap_max = max2 < max1 ? max2 : max1;
+                const float overlap_min = min2 > min1 ? min2 : min1;
+                const float difference = overlap_max - overlap_min;
+                const float new_depth = difference > 0.0f ? difference : 0.0f;
+
+                if(new_depth <= depth) {
+                    const bool flip = (max1 - max2) > 0.0f;
+
+                    depth    = new_depth;
+                    normal_x = flip ? -ax : ax;
+                    normal_y = flip ? -ay : ay;
+                }
+            }
+
+            result.hit[lane]      = hit;
+            result.depth[lane]    = depth;
+            result.normal_x[lane] = normal_x;
+            result.normal_y[lane] = normal_y;
+        }
+    }
+
+#if KIN_X86
+    static void sat_test_batch_sse2(const sat_batch_t& batch, uint32_t count, sat_batch_result_t& result) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 sign = _mm_set1_ps(-0.0f);
+
+        for(uint32_t base = 0; base < count; base += 4) {
+            __m128 depth    = _mm_set1_ps(float_max);
+            __m128 normal_x = zero;
+            __m128 normal_y = zero;
+            __m128 hit      = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+            for(int axis = 0; axis < 4; axis++) {
+                const __m128 ax = _mm_load_ps(&batch.nx[axis][base]);
+                const __m128 ay = _mm_load_ps(&batch.ny[axis][base]);
+
+                __m128 min1 = _mm_add_ps(_mm_mul_ps(_mm_load_ps(&batch.x1[0][base]), ax), _mm_mul_ps(_mm_load_ps(&batch.y1[0][base]), ay));
+                __m128 min2 = _mm_add_ps(_mm_mul_ps(_mm_load_ps(&batch.x2[0][base]), ax), _mm_mul_ps(_mm_load_ps(&batch.y2[0][base]), ay));
+                __m128 max1 = min1;
+                __m128 max2 = min2;
+
+                for(int i = 1; i < 4; i++) {
+                    const __m128 p1 = _mm_add_ps(_mm_mul_ps(_mm_load_ps(&batch.x1[i][base]), ax), _mm_mul_ps(_mm_load_ps(&batch.y1[i][base]), ay));
+                    const __m128 p2 = _mm_add_ps(_mm_mul_ps(_mm_load_ps(&batch.x2[i][base]), ax), _mm_mul_ps(_mm_load_ps(&batch.y2[i][base]), ay));
+
+                    min1 = _mm_min_ps(p1, min1);
+                    max1 = _mm_max_ps(p1, max1);
+                    min2 = _mm_min_ps(p2, min2);
+                    max2 = _mm_max_ps(p2, max2);
+                }
+
+                // lanes that already missed keep their last result, which is never read
+                const __m128 overlaps = _mm_and_ps(_mm_cmpge_ps(max1, min2), _mm_cmpge_ps(max2, min1));
+                const __m128 active   = hit;
+                hit = _mm_and_ps(hit, overlaps);
+
+                const __m128 difference = _mm_sub_ps(_mm_min_ps(max2, max1), _mm_max_ps(min2, min1));
+                const __m128 new_depth  = _mm_max_ps(difference, zero);
+
+                const __m128 replace = _mm_and_ps(active, _mm_cmple_ps(new_depth, depth));
+                const __m128 flip    = _mm_and_ps(_mm_cmpgt_ps(_mm_sub_ps(max1, max2), zero), sign);
+
+                depth    = _mm_or_ps(_mm_and_ps(replace, new_depth), _mm_andnot_ps(replace, depth));
+                normal_x = _mm_or_ps(_mm_and_ps(replace, _mm_xor_ps(ax, flip)), _mm_andnot_ps(replace, normal_x));
+                normal_y = _mm_or_ps(_mm_and_ps(replace, _mm_xor_ps(ay, flip)), _mm_andnot_ps(replace, normal_y));
+            }
+
+            alignas(16) float depths[4], xs[4], ys[4];
+            _mm_store_ps(depths, depth);
+            _mm_store_ps(xs, normal_x);
+            _mm_store_ps(ys, normal_y);
+            const int mask = _mm_movemask_ps(hit);
+
+            for(uint32_t i = 0; i < 4 && base + i < count; i++) {
+                result.hit[base + i]      = (mask >> i) & 1;
+                result.depth[base + i]    = depths[i];
+                result.normal_x[base + i] = xs[i];
+                result.normal_y[base + i] = ys[i];
+            }
+        }
+    }
+
+    KIN_TARGET_AVX2
+    static void sat_test_batch_avx2(const sat_batch_t& batch, uint32_t count, sat_batch_result_t& result) {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 sign = _mm256_set1_ps(-0.0f);
+
+        __m256 depth    = _mm256_set1_ps(float_max);
+        __m256 normal_x = zero;
+        __m256 normal_y = zero;
+        __m256 hit      = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for(int axis = 0; axis < 4; axis++) {
+            const __m256 ax = _mm256_load_ps(batch.nx[axis]);
+            const __m256 ay = _mm256_load_ps(batch.ny[axis]);
+
+            __m256 min1 = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(batch.x1[0]), ax), _mm256_mul_ps(_mm256_load_ps(batch.y1[0]), ay));
+            __m256 min2 = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(batch.x2[0]), ax), _mm256_mul_ps(_mm256_load_ps(batch.y2[0]), ay));
+            __m256 max1 = min1;
+            __m256 max2 = min2;
+
+            for(int i = 1; i < 4; i++) {
+                const __m256 p1 = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(batch.x1[i]), ax), _mm256_mul_ps(_mm256_load_ps(batch.y1[i]), ay));
+                const __m256 p2 = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(batch.x2[i]), ax), _mm256_mul_ps(_mm256_load_ps(batch.y2[i]), ay));
+
+                min1 = _mm256_min_ps(p1, min1);
+                max1 = _mm256_max_ps(p1, max1);
+                min2 = _mm256_min_ps(p2, min2);
+                max2 = _mm256_max_ps(p2, max2);
+            }
+
+            const __m256 overlaps = _mm256_and_ps(_mm256_cmp_ps(max1, min2, _CMP_GE_OQ), _mm256_cmp_ps(max2, min1, _CMP_GE_OQ));
+            const __m256 active   = hit;
+            hit = _mm256_and_ps(hit, overlaps);
+
+            const __m256 difference = _mm256_sub_ps(_mm256_min_ps(max2, max1), _mm256_max_ps(min2, min1));
+            const __m256 new_depth  = _mm256_max_ps(difference, zero);
+
+            const __m256 replace = _mm256_and_ps(active, _mm256_cmp_ps(new_depth, depth, _CMP_LE_OQ));
+            const __m256 flip    = _mm256_and_ps(_mm256_cmp_ps(_mm256_sub_ps(max1, max2), zero, _CMP_GT_OQ), sign);
+
+            depth    = _mm256_blendv_ps(depth, new_depth, replace);
+            normal_x = _mm256_blendv_ps(normal_x, _mm256_xor_ps(ax, flip), replace);
+            normal_y = _mm256_blendv_ps(normal_y, _mm256_xor_ps(ay, flip), replace);
+        }
+
+        alignas(32) float depths[8], xs[8], ys[8];
+        _mm256_store_ps(depths, depth);
+        _mm256_store_ps(xs, normal_x);
+        _mm256_store_ps(ys, normal_y);
+        const int mask = _mm256_movemask_ps(hit);
+
+        for(uint32_t i = 0; i < count; i++) {
+            result.hit[i]      = (mask >> i) & 1;
+            result.depth[i]    = depths[i];
+            result.normal_x[i] = xs[i];
+            result.normal_y[i] = ys[i];
+        }
+    }
+#endif
+
+    void sat_test_batch(const sat_batch_t& batch, uint32_t count, sat_batch_result_t& result, simd_level_t level) {
+        assert(count <= sat_batch_size);
+
+#if KIN_X86
+        if(level == simd_level_avx2) {
+            sat_test_batch_avx2(batch, count, result);
+            return;
+        }
+
+        if(level == simd_level_sse2) {
+            sat_test_batch_sse2(batch, count, result);
+            return;
+        }
+#endif
+
+        sat_test_batch_scalar(batch, count, result);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "obb.hpp"
+#include "simd.hpp"
+
+namespace kin {
+    constexpr uint32_t sat_batch_size = 8;
+
+    // box pairs laid out as structure of arrays, lane i of every array belongs to pair i
+    struct alignas(32) sat_batch_t {
+        float x1[4][sat_batch_size];
+        float y1[4][sat_batch_size];
+        float x2[4][sat_batch_size];
+        float y2[4][sat_batch_size];
+
+        // the two normals of box 1 followed by the two normals of box 2
+        float nx[4][sat_batch_size];
+        float ny[4][sat_batch_size];
+
+        void set(uint32_t lane, const collision_proxy_t& proxy1, const collision_proxy_t& proxy2) {
+            for(int i = 0; i < 4; i++) {
+                x1[i][lane] = proxy1.world_vertices[i].x;
+                y1[i][lane] = proxy1.world_vertices[i].y;
+                x2[i][lane] = proxy2.world_vertices[i].x;
+                y2[i][lane] = proxy2.world_vertices[i].y;
+            }
+
+            for(int i = 0; i < 2; i++) {
+                nx[i][lane]     = proxy1.normals[i].x;
+                ny[i][lane]     = proxy1.normals[i].y;
+                nx[i + 2][lane] = proxy2.normals[i].x;
+                ny[i + 2][lane] = proxy2.normals[i].y;
+            }
+        }
+    };
+
+    struct alignas(32) sat_batch_result_t {
+        float   depth[sat_batch_size];
+        float   normal_x[sat_batch_size];
+        float   normal_y[sat_batch_size];
+        uint8_t hit[sat_batch_size];
+    };
+
+    // runs the seperating axis test on count (at most sat_batch_size) pairs at once. Every 
+    // level gives bitwise identical results, which also match sat_test, as long as 
+    // the compiler is not allowed to contract the projections into fused multiply adds.
+    // Only the first count lanes are written, but wider kernels read every lane, 
+    // so lanes past count must still hold finite values
+    void sat_test_batch(const sat_batch_t& batch, uint32_t count, sat_batch_result_t& result, simd_level_t level);
+
+    inline void sat_test_batch(const sat_batch_t& batch, uint32_t count, sat_batch_result_t& result) {
+        sat_test_batch(batch, count, result, get_simd_level());
+    }
+}
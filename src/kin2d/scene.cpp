@@ -0,0 +1,455 @@
+#include "world.hpp"
+#include <cstring>
+#include <cstdio>
+#include <array>
+#include <map>
+#include <unordered_set>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace kin {
+    mapped_file_t::~mapped_file_t() {
+        close();
+    }
+
+    bool mapped_file_t::read(const char* path) {
+        FILE* file = fopen(path, "rb");
+        if(file == nullptr)
+            return false;
+
+        fseek(file, 0, SEEK_END);
+        const long file_size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        if(file_size <= 0) {
+            fclose(file);
+            return false;
+        }
+
+        contents.resize((size_t)file_size);
+        const bool complete = fread(contents.data(), 1, contents.size(), file) == contents.size();
+        fclose(file);
+
+        if(!complete) {
+            close();
+            return false;
+        }
+
+        view   = contents.data();
+        length = contents.size();
+        return true;
+    }
+
+#if defined(_WIN32)
+    bool mapped_file_t::open(const char* path) {
+        close();
+
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER file_size;
+        if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+            CloseHandle(file);
+            return false;
+        }
+
+        // the mapping keeps the file open by itself
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if(mapping == nullptr)
+            return read(path);
+
+        view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if(view == nullptr) {
+            CloseHandle(mapping);
+            mapping = nullptr;
+            return read(path);
+        }
+
+        length = (size_t)file_size.QuadPart;
+        mapped = true;
+        return true;
+    }
+
+    void mapped_file_t::close() {
+        if(mapped) {
+            UnmapViewOfFile(view);
+            CloseHandle(mapping);
+            mapping = nullptr;
+        }
+
+        contents.clear();
+        contents.shrink_to_fit();
+        view   = nullptr;
+        length = 0;
+        mapped = false;
+    }
+#elif defined(__unix__) || defined(__APPLE__)
+    bool mapped_file_t::open(const char* path) {
+        close();
+
+        int fd = ::open(path, O_RDONLY);
+        if(fd == -1)
+            return false;
+
+        struct stat info;
+        if(fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+
+        // the mapping stays valid after the descriptor is closed
+        void* address = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(address == MAP_FAILED)
+            return read(path);
+
+        view   = address;
+        length = (size_t)info.st_size;
+        mapped = true;
+        return true;
+    }
+
+    void mapped_file_t::close() {
+        if(mapped) {
+            munmap(const_cast<void*>(view), length);
+        }
+
+        contents.clear();
+        contents.shrink_to_fit();
+        view   = nullptr;
+        length = 0;
+        mapped = false;
+    }
+#else
+    bool mapped_file_t::open(const char* path) {
+        close();
+        return read(path);
+    }
+
+    void mapped_file_t::close() {
+        contents.clear();
+        contents.shrink_to_fit();
+        view   = nullptr;
+        length = 0;
+        mapped = false;
+    }
+#endif
+
+    // reads element i of a scene array. Elements written by a newer version can be longer than
+    // ours and their extra fields are skipped, fields missing from older ones are left zero.
+    // Everything goes through memcpy since a mapped file has no alignment guarantees
+    template<typename T>
+    static T read_element(const uint8_t* data, const scene_array_t& array, uint32_t i) {
+        T element = {};
+        memcpy(&element, data + array.offset + (uint64_t)i * array.stride, std::min<size_t>(array.stride, sizeof(T)));
+        return element;
+    }
+
+    template<typename T>
+    static bool is_array_valid(const scene_array_t& array, uint64_t size, uint32_t min_stride = sizeof(T)) {
+        if(array.count == 0)
+            return true;
+
+        if(array.stride < min_stride || array.offset > size)
+            return false;
+
+        // count and stride are 32 bits each so the product can't overflow
+        return (uint64_t)array.count * array.stride <= size - array.offset;
+    }
+
+    // 64 bits so that a corrupt width or height can't wrap around
+    static uint64_t tile_words(const scene_tile_grid_t& grid) {
+        return ((uint64_t)grid.width + 31) / 32 * grid.height;
+    }
+
+    void world_t::save_scene(std::vector<uint8_t>& data) {
+        std::vector<scene_material_t>  materials;
+        std::vector<scene_body_t>      bodies;
+        std::vector<scene_fixture_t>   fixtures;
+        std::vector<scene_tile_grid_t> tile_grids;
+        std::vector<uint32_t>          tiles;
+
+        // most scenes only use a handful of materials, so fixtures refer to a shared table
+        std::map<std::array<uint32_t, 4>, uint32_t> material_indices;
+        auto add_material = [&](float density, float restitution, float static_friction, float dynamic_friction) {
+            const scene_material_t material = {density, restitution, static_friction, dynamic_friction};
+
+            std::array<uint32_t, 4> key;
+            memcpy(key.data(), &material, sizeof(material));
+
+            auto [iter, inserted] = material_indices.emplace(key, (uint32_t)materials.size());
+            if(inserted) {
+                materials.push_back(material);
+            }
+
+            return iter->second;
+        };
+
+        std::unordered_set<fixture_t*> grid_fixtures;
+        std::vector<fixture_t*> body_fixtures;
+
+        for_each_body([&](rigid_body_t* body) {
+            scene_body_t& scene_body = bodies.emplace_back();
+            scene_body.pos           = body->pos();
+            scene_body.rot           = body->rot();
+            scene_body.rotation      = {body->pcos(), body->psin()};
+            scene_body.type          = (uint32_t)body->type;
+            scene_body.linear_vel    = body->linear_vel();
+            scene_body.angular_vel   = body->angular_vel();
+            scene_body.tile_grid     = scene_none;
+
+            // fixtures made by a tile grid are made again from its tiles when loading
+            grid_fixtures.clear();
+            if(tile_grid_t* grid = body->get_tile_grid()) {
+                grid->for_each_fixture([&](fixture_t* fixture) {
+                    grid_fixtures.insert(fixture);
+                });
+            }
+
+            body_fixtures.clear();
+            body->for_each_fixture([&](fixture_t* fixture) {
+                if(grid_fixtures.count(fixture) == 0) {
+                    body_fixtures.push_back(fixture);
+                }
+            });
+
+            // create_fixture adds to the front of the body's list, so fixtures are written
+            // oldest first to have the loaded body add up its mass in the same order
+            scene_body.first_fixture = (uint32_t)fixtures.size();
+            scene_body.fixture_count = (uint32_t)body_fixtures.size();
+            for(auto iter = body_fixtures.rbegin(); iter != body_fixtures.rend(); iter++) {
+                fixture_t* fixture = *iter;
+
+                scene_fixture_t& scene_fixture = fixtures.emplace_back();
+                scene_fixture.pos      = fixture->get_local_pos();
+                scene_fixture.hw       = fixture->hw;
+                scene_fixture.hh       = fixture->hh;
+                scene_fixture.material = add_material(fixture->density, fixture->restitution,
+                                                      fixture->static_friction, fixture->dynamic_friction);
+            }
+
+            tile_grid_t* grid = body->get_tile_grid();
+            if(grid == nullptr)
+                return;
+
+            const tile_grid_def_t& def = grid->get_def();
+            // load_scene would reject it
+            assert(def.width <= scene_max_tile_grid_size && def.height <= scene_max_tile_grid_size);
+
+            scene_body.tile_grid = (uint32_t)tile_grids.size();
+
+            scene_tile_grid_t& scene_grid = tile_grids.emplace_back();
+            scene_grid.width           = def.width;
+            scene_grid.height          = def.height;
+            scene_grid.tile_size       = def.tile_size;
+            scene_grid.offset          = def.offset;
+            scene_grid.material        = add_material(def.density, def.restitution, def.static_friction, def.dynamic_friction);
+            scene_grid.first_tile_word = (uint32_t)tiles.size();
+
+            const uint32_t row_words = (def.width + 31) / 32;
+            tiles.resize(tiles.size() + tile_words(scene_grid), 0);
+
+            uint32_t* grid_tiles = tiles.data() + scene_grid.first_tile_word;
+            for(uint32_t y = 0; y < def.height; y++) {
+                for(uint32_t x = 0; x < def.width; x++) {
+                    if(grid->get_tile(x, y)) {
+                        grid_tiles[y * row_words + x / 32] |= 1u << (x % 32);
+                    }
+                }
+            }
+        });
+
+        const size_t start = data.size();
+        uint64_t offset = sizeof(scene_header_t);
+
+        auto place = [&](scene_array_t& array, uint32_t count, uint32_t stride) {
+            array.offset = offset;
+            array.count  = count;
+            array.stride = stride;
+            offset += (uint64_t)count * stride;
+        };
+
+        scene_header_t header;
+        memset(&header, 0, sizeof(header));
+        header.magic   = scene_magic;
+        header.version = scene_version;
+        place(header.materials,  (uint32_t)materials.size(),  sizeof(scene_material_t));
+        place(header.bodies,     (uint32_t)bodies.size(),     sizeof(scene_body_t));
+        place(header.fixtures,   (uint32_t)fixtures.size(),   sizeof(scene_fixture_t));
+        place(header.tile_grids, (uint32_t)tile_grids.size(), sizeof(scene_tile_grid_t));
+        place(header.tiles,      (uint32_t)tiles.size(),      sizeof(uint32_t));
+        header.size = offset;
+
+        data.resize(start + offset);
+        uint8_t* cursor = data.data() + start;
+        auto write = [&](const void* source, size_t bytes) {
+            if(bytes != 0) {
+                memcpy(cursor, source, bytes);
+            }
+            cursor += bytes;
+        };
+
+        write(&header, sizeof(header));
+        write(materials.data(),  materials.size()  * sizeof(scene_material_t));
+        write(bodies.data(),     bodies.size()     * sizeof(scene_body_t));
+        write(fixtures.data(),   fixtures.size()   * sizeof(scene_fixture_t));
+        write(tile_grids.data(), tile_grids.size() * sizeof(scene_tile_grid_t));
+        write(tiles.data(),      tiles.size()      * sizeof(uint32_t));
+    }
+
+    bool world_t::save_scene(const char* path) {
+        std::vector<uint8_t> data;
+        save_scene(data);
+
+        FILE* file = fopen(path, "wb");
+        if(file == nullptr)
+            return false;
+
+        const bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+        return fclose(file) == 0 && written;
+    }
+
+    bool world_t::load_scene(const void* buffer, size_t size) {
+        const uint8_t* data = (const uint8_t*)buffer;
+
+        if(size < sizeof(scene_header_t))
+            return false;
+
+        scene_header_t header;
+        memcpy(&header, data, sizeof(header));
+
+        if(header.magic != scene_magic || header.version != scene_version || header.size > size)
+            return false;
+
+        const uint64_t scene_size = header.size;
+        if(!is_array_valid<scene_material_t>(header.materials, scene_size) ||
+           !is_array_valid<scene_body_t>(header.bodies, scene_size, scene_body_v1_size) ||
+           !is_array_valid<scene_fixture_t>(header.fixtures, scene_size) ||
+           !is_array_valid<scene_tile_grid_t>(header.tile_grids, scene_size) ||
+           !is_array_valid<uint32_t>(header.tiles, scene_size))
+            return false;
+
+        // everything is checked before the first body is created, so a bad scene leaves the world as it was
+        for(uint32_t i = 0; i < header.fixtures.count; i++) {
+            if(read_element<scene_fixture_t>(data, header.fixtures, i).material >= header.materials.count)
+                return false;
+        }
+
+        for(uint32_t i = 0; i < header.tile_grids.count; i++) {
+            const scene_tile_grid_t grid = read_element<scene_tile_grid_t>(data, header.tile_grids, i);
+
+            if(grid.width > scene_max_tile_grid_size || grid.height > scene_max_tile_grid_size)
+                return false;
+
+            if(grid.material >= header.materials.count || grid.first_tile_word > header.tiles.count ||
+               tile_words(grid) > header.tiles.count - grid.first_tile_word)
+                return false;
+        }
+
+        for(uint32_t i = 0; i < header.bodies.count; i++) {
+            const scene_body_t body = read_element<scene_body_t>(data, header.bodies, i);
+
+            if(body.type > (uint32_t)body_type_dynamic || body.first_fixture > header.fixtures.count ||
+               body.fixture_count > header.fixtures.count - body.first_fixture)
+                return false;
+
+            if(body.tile_grid != scene_none && body.tile_grid >= header.tile_grids.count)
+                return false;
+        }
+
+        auto material_at = [&](uint32_t index) {
+            return read_element<scene_material_t>(data, header.materials, index);
+        };
+
+        // dynamic fixtures go into the broadphase in one go once every body exists
+        begin_bulk_insert();
+        body_store.reserve(header.bodies.count);
+
+        std::vector<fixture_def_t> fixture_defs;
+
+        for(uint32_t i = 0; i < header.bodies.count; i++) {
+            const scene_body_t scene_body = read_element<scene_body_t>(data, header.bodies, i);
+
+            rigid_body_t* body = create_rigid_body(scene_body.pos, scene_body.rot, (body_type_t)scene_body.type);
+            if(header.bodies.stride >= sizeof(scene_body_t)) {
+                body_store.psin[body->index()] = scene_body.rotation.y;
+                body_store.pcos[body->index()] = scene_body.rotation.x;
+            }
+
+            fixture_defs.resize(scene_body.fixture_count);
+            for(uint32_t j = 0; j < scene_body.fixture_count; j++) {
+                const scene_fixture_t  scene_fixture = read_element<scene_fixture_t>(data, header.fixtures, scene_body.first_fixture + j);
+                const scene_material_t material      = material_at(scene_fixture.material);
+
+                fixture_def_t& def = fixture_defs[j];
+                def.density          = material.density;
+                def.restitution      = material.restitution;
+                def.static_friction  = material.static_friction;
+                def.dynamic_friction = material.dynamic_friction;
+                def.hw               = scene_fixture.hw;
+                def.hh               = scene_fixture.hh;
+                def.rel_pos          = scene_fixture.pos;
+            }
+            body->create_fixtures(fixture_defs.data(), scene_body.fixture_count);
+
+            if(scene_body.tile_grid != scene_none) {
+                const scene_tile_grid_t scene_grid = read_element<scene_tile_grid_t>(data, header.tile_grids, scene_body.tile_grid);
+                const scene_material_t  material   = material_at(scene_grid.material);
+
+                tile_grid_def_t def;
+                def.width            = scene_grid.width;
+                def.height           = scene_grid.height;
+                def.tile_size        = scene_grid.tile_size;
+                def.offset           = scene_grid.offset;
+                def.density          = material.density;
+                def.restitution      = material.restitution;
+                def.static_friction  = material.static_friction;
+                def.dynamic_friction = material.dynamic_friction;
+
+                tile_grid_t* grid = body->create_tile_grid(def);
+
+                const uint32_t row_words = (def.width + 31) / 32;
+                for(uint32_t y = 0; y < def.height; y++) {
+                    for(uint32_t x = 0; x < def.width; x++) {
+                        const uint32_t word = read_element<uint32_t>(data, header.tiles, scene_grid.first_tile_word + y * row_words + x / 32);
+
+                        if((word >> (x % 32)) & 1u) {
+                            grid->set_tile(x, y, true);
+                        }
+                    }
+                }
+
+                grid->update();
+            }
+
+            // static bodies ignore velocity, same as apply_linear_velocity
+            if(!body->is_static()) {
+                body->linear_vel()  = scene_body.linear_vel;
+                body->angular_vel() = scene_body.angular_vel;
+            }
+        }
+
+        end_bulk_insert();
+
+        return true;
+    }
+
+    bool world_t::load_scene(const char* path) {
+        mapped_file_t file;
+        if(!file.open(path))
+            return false;
+
+        return load_scene(file.data(), file.size());
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "base.hpp"
+#include <cstddef>
+
+namespace kin {
+    // a scene file is a scene_header_t followed by arrays of the structs below. Arrays are found
+    // through byte offsets from the start of the file and refer to each other by index, never by
+    // pointer, so a file can be used straight from wherever it is mapped. Everything is little endian
+
+    constexpr uint32_t scene_magic   = 0x4e43534b; // "KSCN"
+    constexpr uint32_t scene_version = 1;
+    constexpr uint32_t scene_none    = 0xffffffff;
+
+    struct scene_array_t {
+        uint64_t offset;
+        uint32_t count;
+        // the size of one element, newer versions may only add fields to the end of an element
+        uint32_t stride;
+    };
+
+    struct scene_header_t {
+        uint32_t magic;
+        uint32_t version;
+        // of the whole file
+        uint64_t size;
+
+        scene_array_t materials;  // scene_material_t
+        scene_array_t bodies;     // scene_body_t
+        scene_array_t fixtures;   // scene_fixture_t
+        scene_array_t tile_grids; // scene_tile_grid_t
+        scene_array_t tiles;      // uint32_t, one bit per tile
+    };
+
+    struct scene_material_t {
+        float density;
+        float restitution;
+        float static_friction;
+        float dynamic_friction;
+    };
+
+    struct scene_body_t {
+        glm::vec2 pos;
+        float     rot;
+        uint32_t  type;
+        glm::vec2 linear_vel;
+        float     angular_vel;
+
+        // the body's fixtures are fixtures[first_fixture, first_fixture + fixture_count)
+        uint32_t  first_fixture;
+        uint32_t  fixture_count;
+        // index into tile_grids or scene_none
+        uint32_t  tile_grid;
+
+        // the exact rotation as (cos, sin), rot is rounded. Not in files written 
+        // before it was added, whose bodies are only scene_body_v1_size long
+        glm::vec2 rotation;
+    };
+
+    constexpr uint32_t scene_body_v1_size = 40;
+    static_assert(offsetof(scene_body_t, rotation) == scene_body_v1_size, "fields can only be added to the end of scene_body_t");
+
+    struct scene_fixture_t {
+        glm::vec2 pos;
+        float     hw;
+        float     hh;
+        uint32_t  material;
+    };
+
+    // scenes with a tile grid wider or taller than this are rejected
+    constexpr uint32_t scene_max_tile_grid_size = 1 << 16;
+
+    struct scene_tile_grid_t {
+        uint32_t  width;
+        uint32_t  height;
+        float     tile_size;
+        glm::vec2 offset;
+        uint32_t  material;
+
+        // rows of (width + 31) / 32 words starting at tiles[first_tile_word],
+        // bit x % 32 of word x / 32 of a row is tile x of that row
+        uint32_t  first_tile_word;
+    };
+
+    // a read only view of a whole file, memory mapped where possible and read into memory otherwise
+    class mapped_file_t {
+    public:
+        mapped_file_t() = default;
+        ~mapped_file_t();
+
+        mapped_file_t(const mapped_file_t&) = delete;
+        mapped_file_t& operator=(const mapped_file_t&) = delete;
+
+        bool open(const char* path);
+        void close();
+
+        const void* data() const { return view; }
+        size_t      size() const { return length; }
+
+    private:
+        // reads the whole file into contents, for when it can't be mapped
+        bool read(const char* path);
+
+        const void* view   = nullptr;
+        size_t      length = 0;
+        bool        mapped = false;
+
+#if defined(_WIN32)
+        void* mapping = nullptr;
+#endif
+        // used when the file couldn't be mapped, or on platforms without mmap
+        std::vector<uint8_t> contents;
+    };
+}
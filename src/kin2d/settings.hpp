@@ -3,8 +3,44 @@
 #include "base.hpp"
 
 namespace kin {
-    inline struct {
+    // named so that settings has external linkage, an unnamed struct
+    // would give every translation unit its own copy
+    struct settings_t {
         uint8_t max_tree_depth = 5;
         uint8_t max_elements_in_leaf = 8;
-    } settings;
+
+        // broadphase boxes are fattened by this amount on every side so that
+        // small movements do not require the fixture to be reinserted
+        float aabb_margin = 0.1f;
+        // how far ahead (in steps) the broadphase box is extended in the direction
+        // of a body's velocity
+        float aabb_velocity_multiplier = 2.0f;
+
+        // the size of a cell in the grid broadphase, works best a little over the size of a tile.
+        // Both grid settings are read when the grid is created by world_t::set_broadphase
+        float grid_cell_size = 4.0f;
+        // proxies covering more cells than this are kept in a separate list by the grid broadphase,
+        // and each of them is tested against every other proxy when finding pairs
+        uint32_t grid_max_cells = 64;
+
+        // creates contacts between boxes that aren't touching yet but will this step, 
+        // which stops fast bodies from tunneling without having to use more substeps
+        bool  speculative_contacts = false;
+        // speculative contacts are also created for boxes this close to each other
+        float speculative_distance = 0.02f;
+
+        // how many times the contact solver iterates over every contact each step
+        uint8_t velocity_iterations = 4;
+        // contacts approaching slower than this don't bounce
+        float restitution_velocity  = 0.5f;
+
+        // bodies slower than these for time_to_sleep seconds are put to sleep,
+        // but only once every body they are touching can sleep as well
+        bool  allow_sleep            = true;
+        float sleep_linear_velocity  = 0.05f;
+        float sleep_angular_velocity = 0.05f;
+        float time_to_sleep          = 0.5f;
+    };
+
+    inline settings_t settings;
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "simd.hpp"
+
+#if KIN_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace kin {
+    simd_level_t detect_simd_level() {
+#if KIN_X86 && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx2"))
+            return simd_level_avx2;
+        if(__builtin_cpu_supports("sse2"))
+            return simd_level_sse2;
+#elif KIN_X86 && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const int max_leaf = info[0];
+
+        __cpuid(info, 1);
+        const bool has_sse2    = (info[3] & (1 << 26)) != 0;
+        const bool has_osxsave = (info[2] & (1 << 27)) != 0;
+        const bool has_avx     = (info[2] & (1 << 28)) != 0;
+
+        // the os must also save the ymm registers
+        bool has_avx2 = false;
+        if(max_leaf >= 7 && has_osxsave && has_avx && (_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            has_avx2 = (info[1] & (1 << 5)) != 0;
+        }
+
+        if(has_avx2)
+            return simd_level_avx2;
+        if(has_sse2)
+            return simd_level_sse2;
+#endif
+        return simd_level_scalar;
+    }
+
+    static simd_level_t& current_level() {
+        static simd_level_t level = detect_simd_level();
+        return level;
+    }
+
+    simd_level_t get_simd_level() {
+        return current_level();
+    }
+
+    void set_simd_level(simd_level_t level) {
+        current_level() = std::min(level, detect_simd_level());
+    }
+
+    const char* simd_level_name(simd_level_t level) {
+        switch(level) {
+        case simd_level_avx2: return "avx2";
+        case simd_level_sse2: return "sse2";
+        default:              return "scalar";
+        }
+    }
+}
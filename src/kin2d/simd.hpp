@@ -0,0 +1,40 @@
+#pragma once
+
+#include "base.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define KIN_X86 1
+#else
+#define KIN_X86 0
+#endif
+
+#if KIN_X86
+#include <immintrin.h>
+#endif
+
+// marks a function as allowed to use AVX2 without building everything for it
+#if KIN_X86 && (defined(__GNUC__) || defined(__clang__))
+#define KIN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define KIN_TARGET_AVX2
+#endif
+
+namespace kin {
+    enum simd_level_t: int {
+        simd_level_scalar = 0,
+        simd_level_sse2   = 1,
+        simd_level_avx2   = 2
+    };
+
+    // the best instruction set the cpu running this supports
+    simd_level_t detect_simd_level();
+
+    // the level used by the batched kernels, detect_simd_level() unless overriden
+    simd_level_t get_simd_level();
+
+    // forces the batched kernels to use a lower level, for testing and benchmarking.
+    // A level higher than detect_simd_level() is clamped
+    void set_simd_level(simd_level_t level);
+
+    const char* simd_level_name(simd_level_t level);
+}
@@ -0,0 +1,180 @@
+#include "world.hpp"
+#include <cstring>
+
+namespace kin {
+    // fnv-1a over 8 bytes at a time, the tail byte by byte
+    static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        constexpr uint64_t prime = 1099511628211ull;
+
+        size_t i = 0;
+        for(; i + 8 <= size; i += 8) {
+            uint64_t word;
+            memcpy(&word, bytes + i, sizeof(word));
+            hash = (hash ^ word) * prime;
+        }
+
+        for(; i < size; i++) {
+            hash = (hash ^ bytes[i]) * prime;
+        }
+
+        return hash;
+    }
+
+    // every array of the body store that update reads or writes, in the order they are stored
+    template<typename S, typename F>
+    static void for_each_store_array(S& store, F&& fn) {
+        fn(store.pos);
+        fn(store.psin);
+        fn(store.pcos);
+        fn(store.linear_vel);
+        fn(store.angular_vel);
+        fn(store.forces);
+        fn(store.torque);
+        fn(store.invmass);
+        fn(store.invinertia);
+        fn(store.motion);
+        fn(store.awake);
+        fn(store.sleep_time);
+        fn(store.island_next);
+    }
+
+    size_t world_t::snapshot_size() const {
+        size_t size = sizeof(snapshot_header_t);
+        size_t fixtures = 0;
+
+        for_each_store_array(body_store, [&](const auto& array) {
+            size += array.size() * sizeof(array[0]);
+        });
+
+        for(rigid_body_t* body : body_store.bodies) {
+            body->for_each_fixture([&](fixture_t*) {
+                fixtures++;
+            });
+        }
+
+        size += proxies.size() * sizeof(collision_proxy_t);
+        size += fixtures * sizeof(aabb_t);
+        size += contact_cache.size() * sizeof(cached_contact_t);
+
+        return size;
+    }
+
+    size_t world_t::save_snapshot(void* buffer, size_t size) const {
+        const size_t needed = snapshot_size();
+        if(size < needed)
+            return 0;
+
+        uint8_t* cursor = (uint8_t*)buffer + sizeof(snapshot_header_t);
+        auto write = [&](const void* data, size_t bytes) {
+            memcpy(cursor, data, bytes);
+            cursor += bytes;
+        };
+
+        for_each_store_array(body_store, [&](const auto& array) {
+            write(array.data(), array.size() * sizeof(array[0]));
+        });
+
+        write(proxies.data(), proxies.size() * sizeof(collision_proxy_t));
+
+        // the broadphase boxes are the only state not kept in arrays,
+        // they are gathered in body store and fixture order
+        uint32_t fixtures = 0;
+        for(rigid_body_t* body : body_store.bodies) {
+            body->for_each_fixture([&](fixture_t* fixture) {
+                write(static_cast<const aabb_t*>(&relement_pool[fixture->relement_id]), sizeof(aabb_t));
+                fixtures++;
+            });
+        }
+
+        write(contact_cache.data(), contact_cache.size() * sizeof(cached_contact_t));
+
+        snapshot_header_t header;
+        header.magic            = snapshot_magic;
+        header.version          = snapshot_version;
+        header.world            = (uint64_t)(uintptr_t)this;
+        header.topology_version = topology_version;
+        header.size             = needed;
+        header.bodies           = (uint32_t)body_store.size();
+        header.proxies          = (uint32_t)proxies.size();
+        header.fixtures         = fixtures;
+        header.contacts         = (uint32_t)contact_cache.size();
+        header.gravity          = gravity;
+        memcpy(buffer, &header, sizeof(header));
+
+        return needed;
+    }
+
+    bool world_t::restore_snapshot(const void* buffer, size_t size) {
+        if(size < sizeof(snapshot_header_t))
+            return false;
+
+        snapshot_header_t header;
+        memcpy(&header, buffer, sizeof(header));
+
+        if(header.magic != snapshot_magic || header.version != snapshot_version || header.size > size ||
+           header.world != (uint64_t)(uintptr_t)this || header.topology_version != topology_version)
+            return false;
+
+        // the same topology means every array still has the size it had
+        assert(header.bodies == body_store.size() && header.proxies == proxies.size());
+
+        const uint8_t* cursor = (const uint8_t*)buffer + sizeof(snapshot_header_t);
+        auto read = [&](void* data, size_t bytes) {
+            memcpy(data, cursor, bytes);
+            cursor += bytes;
+        };
+
+        for_each_store_array(body_store, [&](auto& array) {
+            read(array.data(), array.size() * sizeof(array[0]));
+        });
+
+        read(proxies.data(), proxies.size() * sizeof(collision_proxy_t));
+
+        // only boxes that changed since the snapshot have to be moved in the broadphase,
+        // over a few steps of rollback that is usually only the bodies that were moving
+        for(rigid_body_t* body : body_store.bodies) {
+            body->for_each_fixture([&](fixture_t* fixture) {
+                rtree_element_t& relement = relement_pool[fixture->relement_id];
+
+                aabb_t aabb;
+                read(&aabb, sizeof(aabb));
+
+                if(memcmp(&aabb, static_cast<aabb_t*>(&relement), sizeof(aabb)) == 0)
+                    return;
+
+                static_cast<aabb_t&>(relement) = aabb;
+
+                if(body->is_static()) {
+                    static_tree_dirty = true;
+                } else {
+                    broadphase->remove((uint32_t)fixture->relement_id);
+                    broadphase->insert((uint32_t)fixture->relement_id, relement);
+                }
+            });
+        }
+
+        contact_cache.resize(header.contacts);
+        read(contact_cache.data(), contact_cache.size() * sizeof(cached_contact_t));
+
+        // the snapshot may have been taken before the proxies were refreshed for a query
+        proxies_stale = true;
+
+        gravity = header.gravity;
+
+        return true;
+    }
+
+    uint64_t world_t::state_hash() const {
+        uint64_t hash = 14695981039346656037ull;
+
+        hash = hash_bytes(hash, body_store.pos.data(), body_store.pos.size() * sizeof(glm::vec2));
+        hash = hash_bytes(hash, body_store.psin.data(), body_store.psin.size() * sizeof(float));
+        hash = hash_bytes(hash, body_store.pcos.data(), body_store.pcos.size() * sizeof(float));
+        hash = hash_bytes(hash, body_store.linear_vel.data(), body_store.linear_vel.size() * sizeof(glm::vec2));
+        hash = hash_bytes(hash, body_store.angular_vel.data(), body_store.angular_vel.size() * sizeof(float));
+        hash = hash_bytes(hash, body_store.awake.data(), body_store.awake.size() * sizeof(uint8_t));
+
+        return hash;
+    }
+}
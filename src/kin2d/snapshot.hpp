@@ -0,0 +1,27 @@
+#pragma once
+
+#include "base.hpp"
+
+namespace kin {
+    constexpr uint32_t snapshot_magic   = 0x504e534b; // "KSNP"
+    constexpr uint32_t snapshot_version = 1;
+
+    // the start of every snapshot written by world_t::save_snapshot, followed by 
+    // the body store arrays, the collision proxies, the fattened box of every 
+    // fixture and the contact cache, each copied as one block
+    struct snapshot_header_t {
+        uint32_t magic;
+        uint32_t version;
+        // snapshots can only be restored into the world that took them, with the same bodies and fixtures
+        uint64_t world;
+        uint64_t topology_version;
+        uint64_t size;
+
+        uint32_t bodies;
+        uint32_t proxies;
+        uint32_t fixtures;
+        uint32_t contacts;
+
+        glm::vec2 gravity;
+    };
+}
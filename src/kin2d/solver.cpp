@@ -0,0 +1,271 @@
+#include "solver.hpp"
+#include "settings.hpp"
+
+namespace kin {
+    // the velocity of a point on a body
+    static glm::vec2 point_velocity(glm::vec2 linear_vel, float angular_vel, glm::vec2 r) {
+        return linear_vel + glm::vec2(-angular_vel * r.y, angular_vel * r.x);
+    }
+
+    static void apply_impulse(const contact_constraint_t& constraint, const contact_point_t& point, glm::vec2 impulse, body_store_t& store) {
+        if(constraint.dynamic1) {
+            store.linear_vel[constraint.body1]  -= impulse * store.invmass[constraint.body1];
+            store.angular_vel[constraint.body1] -= cross(point.r1, impulse) * store.invinertia[constraint.body1];
+        }
+
+        if(constraint.dynamic2) {
+            store.linear_vel[constraint.body2]  += impulse * store.invmass[constraint.body2];
+            store.angular_vel[constraint.body2] += cross(point.r2, impulse) * store.invinertia[constraint.body2];
+        }
+    }
+
+    static glm::vec2 relative_velocity(const contact_constraint_t& constraint, const contact_point_t& point, const body_store_t& store) {
+        glm::vec2 vel1 = point_velocity(store.linear_vel[constraint.body1], store.angular_vel[constraint.body1], point.r1);
+        glm::vec2 vel2 = point_velocity(store.linear_vel[constraint.body2], store.angular_vel[constraint.body2], point.r2);
+
+        return vel2 - vel1;
+    }
+
+    void color_contacts(const contact_constraint_t* constraints, uint32_t count, uint64_t* body_colors, uint8_t* colors) {
+        for(uint32_t k = 0; k < count; k++) {
+            const contact_constraint_t& constraint = constraints[k];
+
+            uint64_t used = 0;
+            if(constraint.dynamic1)
+                used |= body_colors[constraint.body1];
+            if(constraint.dynamic2)
+                used |= body_colors[constraint.body2];
+
+            uint32_t color = 0;
+            while(color < max_contact_colors && (used & (1ull << color))) {
+                color++;
+            }
+
+            if(color < max_contact_colors) {
+                if(constraint.dynamic1)
+                    body_colors[constraint.body1] |= 1ull << color;
+                if(constraint.dynamic2)
+                    body_colors[constraint.body2] |= 1ull << color;
+            }
+
+            colors[k] = (uint8_t)color;
+        }
+    }
+
+    void prepare_contact(contact_constraint_t& constraint, const collision_manifold_t& manifold, const body_store_t& store, float step) {
+        const rigid_body_t& body1 = *store.bodies[constraint.body1];
+        const rigid_body_t& body2 = *store.bodies[constraint.body2];
+
+        const float invmass1    = store.invmass[constraint.body1];
+        const float invmass2    = store.invmass[constraint.body2];
+        const float invinertia1 = store.invinertia[constraint.body1];
+        const float invinertia2 = store.invinertia[constraint.body2];
+
+        const glm::vec2 center1 = store.pos[constraint.body1] + body1.center_of_mass;
+        const glm::vec2 center2 = store.pos[constraint.body2] + body2.center_of_mass;
+
+        constraint.normal      = manifold.normal;
+        constraint.friction    = manifold.dynamic_friction;
+        constraint.restitution = manifold.restitution;
+        constraint.count       = manifold.count;
+
+        const glm::vec2 tangent = {manifold.normal.y, -manifold.normal.x};
+
+        for(uint8_t i = 0; i < manifold.count; i++) {
+            contact_point_t& point = constraint.points[i];
+
+            point.feature         = manifold.features[i];
+            point.normal_impulse  = 0.0f;
+            point.tangent_impulse = 0.0f;
+
+            point.r1 = manifold.points[i] - center1;
+            point.r2 = manifold.points[i] - center2;
+
+            const float rn1 = cross(point.r1, manifold.normal);
+            const float rn2 = cross(point.r2, manifold.normal);
+            const float rt1 = cross(point.r1, tangent);
+            const float rt2 = cross(point.r2, tangent);
+
+            const float normal_k  = invmass1 + invmass2 + invinertia1 * rn1 * rn1 + invinertia2 * rn2 * rn2;
+            const float tangent_k = invmass1 + invmass2 + invinertia1 * rt1 * rt1 + invinertia2 * rt2 * rt2;
+
+            point.normal_mass  = normal_k  > 0.0f ? 1.0f / normal_k  : 0.0f;
+            point.tangent_mass = tangent_k > 0.0f ? 1.0f / tangent_k : 0.0f;
+
+            // a speculative contact lets the bodies approach by as much 
+            // as closes the gap in one step, but not any faster
+            if(manifold.depth < 0.0f) {
+                point.velocity_bias = manifold.depth / step;
+                continue;
+            }
+
+            // restitution is based on the approach velocity before any impulses
+            // are applied, slow contacts don't bounce so that stacks can rest
+            const float approach = glm::dot(relative_velocity(constraint, point, store), manifold.normal);
+
+            point.velocity_bias = 0.0f;
+            if(approach < -settings.restitution_velocity) {
+                point.velocity_bias = -constraint.restitution * approach;
+            }
+        }
+
+        constraint.block = false;
+        if(manifold.count == 2) {
+            const float rn11 = cross(constraint.points[0].r1, manifold.normal);
+            const float rn12 = cross(constraint.points[0].r2, manifold.normal);
+            const float rn21 = cross(constraint.points[1].r1, manifold.normal);
+            const float rn22 = cross(constraint.points[1].r2, manifold.normal);
+
+            const float k11 = invmass1 + invmass2 + invinertia1 * rn11 * rn11 + invinertia2 * rn12 * rn12;
+            const float k22 = invmass1 + invmass2 + invinertia1 * rn21 * rn21 + invinertia2 * rn22 * rn22;
+            const float k12 = invmass1 + invmass2 + invinertia1 * rn11 * rn21 + invinertia2 * rn12 * rn22;
+            const float det = k11 * k22 - k12 * k12;
+
+            // points too close together make the matrix close to singular, those are solved one by one
+            constexpr float max_condition = 1000.0f;
+            if(k11 * k11 < max_condition * det) {
+                constraint.block    = true;
+                constraint.k[0]     = k11;
+                constraint.k[1]     = k12;
+                constraint.k[2]     = k22;
+                constraint.inv_k[0] =  k22 / det;
+                constraint.inv_k[1] = -k12 / det;
+                constraint.inv_k[2] =  k11 / det;
+            }
+        }
+    }
+
+    void match_cached_contact(contact_constraint_t& constraint, const std::vector<cached_contact_t>& cache, size_t& cursor) {
+        while(cursor < cache.size() && cache[cursor].key < constraint.key) {
+            cursor++;
+        }
+
+        if(cursor == cache.size() || cache[cursor].key != constraint.key)
+            return;
+
+        const cached_contact_t& cached = cache[cursor];
+        for(uint8_t i = 0; i < constraint.count; i++) {
+            for(uint8_t j = 0; j < cached.count; j++) {
+                if(constraint.points[i].feature == cached.features[j]) {
+                    constraint.points[i].normal_impulse  = cached.normal_impulse[j];
+                    constraint.points[i].tangent_impulse = cached.tangent_impulse[j];
+                    break;
+                }
+            }
+        }
+    }
+
+    void warm_start_contact(const contact_constraint_t& constraint, body_store_t& store) {
+        const glm::vec2 tangent = {constraint.normal.y, -constraint.normal.x};
+
+        for(uint8_t i = 0; i < constraint.count; i++) {
+            const contact_point_t& point = constraint.points[i];
+
+            glm::vec2 impulse = constraint.normal * point.normal_impulse + tangent * point.tangent_impulse;
+            apply_impulse(constraint, point, impulse, store);
+        }
+    }
+
+    // solves both normal impulses of a two point contact as one linear complementarity problem,
+    // trying each combination of active points in turn. Follows box2d's block solver
+    static void solve_normal_block(contact_constraint_t& constraint, body_store_t& store) {
+        contact_point_t& point1 = constraint.points[0];
+        contact_point_t& point2 = constraint.points[1];
+
+        const float a1 = point1.normal_impulse;
+        const float a2 = point2.normal_impulse;
+
+        const float vn1 = glm::dot(relative_velocity(constraint, point1, store), constraint.normal);
+        const float vn2 = glm::dot(relative_velocity(constraint, point2, store), constraint.normal);
+
+        // the velocities the points would have without any of the accumulated impulses
+        const float b1 = vn1 - point1.velocity_bias - (constraint.k[0] * a1 + constraint.k[1] * a2);
+        const float b2 = vn2 - point2.velocity_bias - (constraint.k[1] * a1 + constraint.k[2] * a2);
+
+        float x1, x2;
+
+        for(;;) {
+            // both points pushing
+            x1 = -(constraint.inv_k[0] * b1 + constraint.inv_k[1] * b2);
+            x2 = -(constraint.inv_k[1] * b1 + constraint.inv_k[2] * b2);
+            if(x1 >= 0.0f && x2 >= 0.0f)
+                break;
+
+            // only the first point pushing, the second one must be separating
+            x1 = -b1 / constraint.k[0];
+            x2 = 0.0f;
+            if(x1 >= 0.0f && constraint.k[1] * x1 + b2 >= 0.0f)
+                break;
+
+            // only the second point pushing
+            x1 = 0.0f;
+            x2 = -b2 / constraint.k[2];
+            if(x2 >= 0.0f && constraint.k[1] * x2 + b1 >= 0.0f)
+                break;
+
+            // neither pushing
+            x1 = 0.0f;
+            x2 = 0.0f;
+            if(b1 >= 0.0f && b2 >= 0.0f)
+                break;
+
+            // no solution, which only happens through round off, keep the last impulses
+            return;
+        }
+
+        point1.normal_impulse = x1;
+        point2.normal_impulse = x2;
+
+        apply_impulse(constraint, point1, constraint.normal * (x1 - a1), store);
+        apply_impulse(constraint, point2, constraint.normal * (x2 - a2), store);
+    }
+
+    void solve_contact(contact_constraint_t& constraint, body_store_t& store) {
+        const glm::vec2 tangent = {constraint.normal.y, -constraint.normal.x};
+
+        // friction first, as the normal impulse is more important to get right
+        for(uint8_t i = 0; i < constraint.count; i++) {
+            contact_point_t& point = constraint.points[i];
+
+            float lambda = -glm::dot(relative_velocity(constraint, point, store), tangent) * point.tangent_mass;
+
+            // coulomb friction, clamped by the normal impulse accumulated so far
+            const float max_friction = constraint.friction * point.normal_impulse;
+            const float new_impulse  = glm::clamp(point.tangent_impulse + lambda, -max_friction, max_friction);
+            lambda = new_impulse - point.tangent_impulse;
+            point.tangent_impulse = new_impulse;
+
+            apply_impulse(constraint, point, tangent * lambda, store);
+        }
+
+        if(constraint.block) {
+            solve_normal_block(constraint, store);
+            return;
+        }
+
+        for(uint8_t i = 0; i < constraint.count; i++) {
+            contact_point_t& point = constraint.points[i];
+
+            const float vn = glm::dot(relative_velocity(constraint, point, store), constraint.normal);
+            float lambda = -point.normal_mass * (vn - point.velocity_bias);
+
+            // the accumulated impulse may only ever push
+            const float new_impulse = glm::max(point.normal_impulse + lambda, 0.0f);
+            lambda = new_impulse - point.normal_impulse;
+            point.normal_impulse = new_impulse;
+
+            apply_impulse(constraint, point, constraint.normal * lambda, store);
+        }
+    }
+
+    void store_cached_contact(const contact_constraint_t& constraint, cached_contact_t& cached) {
+        cached.key   = constraint.key;
+        cached.count = constraint.count;
+
+        for(uint8_t i = 0; i < constraint.count; i++) {
+            cached.features[i]        = constraint.points[i].feature;
+            cached.normal_impulse[i]  = constraint.points[i].normal_impulse;
+            cached.tangent_impulse[i] = constraint.points[i].tangent_impulse;
+        }
+    }
+}
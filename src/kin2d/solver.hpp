@@ -0,0 +1,79 @@
+#pragma once
+
+#include "collision.hpp"
+
+namespace kin {
+    struct contact_point_t {
+        glm::vec2 r1; // from each body's center of mass to the point
+        glm::vec2 r2;
+
+        float normal_mass;
+        float tangent_mass;
+        float velocity_bias;
+
+        // accumulated over every iteration, and carried over to the next step
+        float normal_impulse;
+        float tangent_impulse;
+
+        contact_feature_t feature;
+    };
+
+    // a touching pair prepared for the sequential impulse solver
+    struct contact_constraint_t {
+        uint32_t pair; // index into the world's pair buffer
+        uint64_t key;  // the pair's key
+
+        // body store indices, only dynamic bodies are ever written to
+        uint32_t body1;
+        uint32_t body2;
+        bool     dynamic1;
+        bool     dynamic2;
+
+        glm::vec2 normal;
+        float     friction;
+        float     restitution;
+
+        uint8_t         count;
+        contact_point_t points[2];
+
+        // with two points both normal impulses are solved together, a single 
+        // contact taking a whole hard impact converges far too slowly otherwise.
+        // k is the symmetric effective mass matrix (k11, k12, k22) and inv_k its inverse
+        bool  block;
+        float k[3];
+        float inv_k[3];
+    };
+
+    // the impulses of a contact from the last step, used to warm start the next one
+    struct cached_contact_t {
+        uint64_t          key;
+        uint8_t           count;
+        contact_feature_t features[2];
+        float             normal_impulse[2];
+        float             tangent_impulse[2];
+    };
+
+    // constraints that don't fit in any color are solved on their own after every color
+    constexpr uint32_t max_contact_colors = 64;
+
+    // greedy coloring in constraint order, a constraint takes the lowest color neither of its 
+    // dynamic bodies has yet. Static bodies are never written to so they don't conflict.
+    // body_colors is a mask of the colors each body has and must start out zeroed.
+    // Constraints that don't fit in any color get max_contact_colors
+    void color_contacts(const contact_constraint_t* constraints, uint32_t count, uint64_t* body_colors, uint8_t* colors);
+
+    // fills the constraint out of a manifold, body positions must be final
+    void prepare_contact(contact_constraint_t& constraint, const collision_manifold_t& manifold, const body_store_t& store, float step);
+
+    // copies the impulses of matching features from the last step, the cache is
+    // sorted by key and cursor is advanced along it, so constraints must be passed in key order
+    void match_cached_contact(contact_constraint_t& constraint, const std::vector<cached_contact_t>& cache, size_t& cursor);
+
+    // applies the impulses the constraint starts with
+    void warm_start_contact(const contact_constraint_t& constraint, body_store_t& store);
+
+    // one sequential impulse iteration, friction first then the normal impulse
+    void solve_contact(contact_constraint_t& constraint, body_store_t& store);
+
+    void store_cached_contact(const contact_constraint_t& constraint, cached_contact_t& cached);
+}
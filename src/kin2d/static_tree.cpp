@@ -0,0 +1,92 @@
+#include "static_tree.hpp"
+
+namespace kin {
+    static float center(const aabb_t& aabb, int axis) {
+        return (aabb.min[axis] + aabb.max[axis]) * 0.5f;
+    }
+
+    static aabb_t merge(const aabb_t& a, const aabb_t& b) {
+        return {
+            {std::min(a.min[0], b.min[0]), std::min(a.min[1], b.min[1])},
+            {std::max(a.max[0], b.max[0]), std::max(a.max[1], b.max[1])}
+        };
+    }
+
+    void sort_tile_recursive(std::vector<static_tree_t::entry_t>& entries, size_t node_size) {
+        using entry_t = static_tree_t::entry_t;
+
+        if(entries.empty())
+            return;
+
+        // sort by x, cut into vertical slices of whole leaves, then sort every slice by y
+        const size_t leaf_count  = (entries.size() + node_size - 1) / node_size;
+        const size_t slice_count = (size_t)std::ceil(std::sqrt((double)leaf_count));
+        const size_t slice_size  = ((leaf_count + slice_count - 1) / slice_count) * node_size;
+
+        std::sort(entries.begin(), entries.end(), [](const entry_t& a, const entry_t& b) {
+            return center(a.aabb, 0) < center(b.aabb, 0);
+        });
+
+        for(size_t begin = 0; begin < entries.size(); begin += slice_size) {
+            const size_t end = std::min(begin + slice_size, entries.size());
+
+            std::sort(entries.begin() + begin, entries.begin() + end, [](const entry_t& a, const entry_t& b) {
+                return center(a.aabb, 1) < center(b.aabb, 1);
+            });
+        }
+    }
+
+    void static_tree_t::build(std::vector<entry_t>& new_entries) {
+        clear();
+        entries.swap(new_entries);
+
+        if(entries.empty())
+            return;
+
+        sort_tile_recursive(entries, node_size);
+
+        const size_t leaf_count = (entries.size() + node_size - 1) / node_size;
+        nodes.reserve(leaf_count + leaf_count / (node_size - 1) + 1);
+
+        for(size_t first = 0; first < entries.size(); first += node_size) {
+            node_t node;
+            node.first = (uint32_t)first;
+            node.count = (uint16_t)std::min<size_t>(node_size, entries.size() - first);
+            node.leaf  = true;
+            node.aabb  = entries[first].aabb;
+
+            for(uint32_t i = node.first + 1; i < node.first + node.count; i++) {
+                node.aabb = merge(node.aabb, entries[i].aabb);
+            }
+
+            nodes.push_back(node);
+        }
+
+        // the leaves are already in spatial order, so neighbouring nodes are grouped as they are
+        size_t level_begin = 0;
+        size_t level_end   = nodes.size();
+        while(level_end - level_begin > 1) {
+            for(size_t first = level_begin; first < level_end; first += node_size) {
+                node_t node;
+                node.first = (uint32_t)first;
+                node.count = (uint16_t)std::min<size_t>(node_size, level_end - first);
+                node.leaf  = false;
+                node.aabb  = nodes[first].aabb;
+
+                for(uint32_t i = node.first + 1; i < node.first + node.count; i++) {
+                    node.aabb = merge(node.aabb, nodes[i].aabb);
+                }
+
+                nodes.push_back(node);
+            }
+
+            level_begin = level_end;
+            level_end   = nodes.size();
+        }
+    }
+
+    void static_tree_t::clear() {
+        nodes.clear();
+        entries.clear();
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "aabb.hpp"
+
+namespace kin {
+    // a bounding volume hierarchy for boxes that never move. It is packed with sort tile
+    // recursive in one go, and has to be rebuilt from scratch whenever its contents change
+    class static_tree_t {
+    public:
+        static constexpr uint32_t node_size = 8;
+
+        struct entry_t {
+            aabb_t   aabb;
+            uint32_t id;
+        };
+
+        // takes the entries and builds the tree over them, the order of entries is not kept
+        void build(std::vector<entry_t>& entries);
+        void clear();
+
+        size_t size() const { return entries.size(); }
+
+        // calls callback(id) for every entry whose box overlaps aabb
+        template<typename F>
+        void query(const aabb_t& aabb, F&& callback) const {
+            if(nodes.empty())
+                return;
+
+            // each level holds at most node_size children per node, so 
+            // the stack stays small for any tree that fits in memory
+            uint32_t stack[128];
+            uint32_t top = 0;
+            stack[top++] = (uint32_t)nodes.size() - 1;
+
+            while(top != 0) {
+                const node_t& node = nodes[stack[--top]];
+                if(!aabb_collide(node.aabb, aabb))
+                    continue;
+
+                if(node.leaf) {
+                    for(uint32_t i = node.first; i < node.first + node.count; i++) {
+                        if(aabb_collide(entries[i].aabb, aabb)) {
+                            callback(entries[i].id);
+                        }
+                    }
+                } else {
+                    for(uint32_t i = node.first; i < node.first + node.count; i++) {
+                        stack[top++] = i;
+                    }
+                }
+            }
+        }
+
+    private:
+        struct node_t {
+            aabb_t   aabb;
+            // children are entries in leaves, and nodes everywhere else
+            uint32_t first;
+            uint16_t count;
+            bool     leaf;
+        };
+
+        // nodes are stored level by level starting with the leaves, the root is last
+        std::vector<node_t>  nodes;
+        std::vector<entry_t> entries;
+    };
+
+    // orders entries with sort tile recursive, after which every run of node_size 
+    // entries is a tight group of neighbours. Used by anything that builds a tree in one go
+    void sort_tile_recursive(std::vector<static_tree_t::entry_t>& entries, size_t node_size);
+}
@@ -0,0 +1,82 @@
+#include "thread_pool.hpp"
+
+namespace kin {
+    thread_pool_t::~thread_pool_t() {
+        stop_workers();
+    }
+
+    void thread_pool_t::set_worker_count(uint32_t worker_count) {
+        stop_workers();
+
+        stop = false;
+        for(uint32_t i = 0; i < worker_count; i++) {
+            // a resized pool has already run earlier tasks, which the new workers must skip
+            workers.emplace_back(&thread_pool_t::worker_main, this, i + 1, generation);
+        }
+    }
+
+    void thread_pool_t::stop_workers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        start_cv.notify_all();
+
+        for(std::thread& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+    void thread_pool_t::run(uint32_t count, uint32_t grain_size, task_fn_t fn, void* new_context) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task       = fn;
+            context    = new_context;
+            task_count = count;
+            grain      = grain_size == 0 ? 1 : grain_size;
+            next_begin = 0;
+            busy       = (uint32_t)workers.size();
+            generation++;
+        }
+        start_cv.notify_all();
+
+        work(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [&](){ return busy == 0; });
+    }
+
+    void thread_pool_t::work(uint32_t thread_index) {
+        while(true) {
+            uint32_t begin = next_begin.fetch_add(grain);
+            if(begin >= task_count)
+                break;
+
+            uint32_t end = std::min(begin + grain, task_count);
+            task(context, begin, end, thread_index);
+        }
+    }
+
+    void thread_pool_t::worker_main(uint32_t thread_index, uint64_t seen_generation) {
+        while(true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                start_cv.wait(lock, [&](){ return stop || generation != seen_generation; });
+
+                if(stop)
+                    return;
+
+                seen_generation = generation;
+            }
+
+            work(thread_index);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busy--;
+            }
+            done_cv.notify_one();
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "base.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace kin {
+    // a small pool of worker threads used to split up loops in the world step.
+    // Dispatching work never allocates
+    class thread_pool_t {
+    public:
+        thread_pool_t() = default;
+        ~thread_pool_t();
+
+        thread_pool_t(const thread_pool_t&) = delete;
+        thread_pool_t& operator=(const thread_pool_t&) = delete;
+
+        // stops the current workers and starts worker_count new ones,
+        // 0 runs everything on the calling thread
+        void set_worker_count(uint32_t worker_count);
+
+        // the amount of threads that take part in a parallel_for, including the caller
+        uint32_t thread_count() const { return (uint32_t)workers.size() + 1; }
+
+        // calls fn(begin, end, thread_index) over chunks of [0, count), and blocks until
+        // every chunk is done. The calling thread takes part as thread 0. Which thread gets
+        // which chunk is not deterministic, so fn should only write to its own range
+        template<typename F>
+        void parallel_for(uint32_t count, uint32_t grain_size, F&& fn) {
+            typedef std::remove_reference_t<F> fn_t;
+
+            if(workers.empty() || count <= grain_size) {
+                if(count != 0) {
+                    fn(0, count, 0);
+                }
+
+                return;
+            }
+
+            run(count, grain_size, [](void* context, uint32_t begin, uint32_t end, uint32_t thread_index) {
+                (*(fn_t*)context)(begin, end, thread_index);
+            }, (void*)std::addressof(fn));
+        }
+
+    private:
+        typedef void(*task_fn_t)(void* context, uint32_t begin, uint32_t end, uint32_t thread_index);
+
+        void run(uint32_t count, uint32_t grain_size, task_fn_t fn, void* context);
+        void worker_main(uint32_t thread_index, uint64_t seen_generation);
+        void work(uint32_t thread_index);
+        void stop_workers();
+
+        std::vector<std::thread> workers;
+
+        std::mutex              mutex;
+        std::condition_variable start_cv;
+        std::condition_variable done_cv;
+        uint64_t                generation = 0;
+        uint32_t                busy       = 0;
+        bool                    stop       = false;
+
+        task_fn_t             task       = nullptr;
+        void*                 context    = nullptr;
+        uint32_t              task_count = 0;
+        uint32_t              grain      = 1;
+        std::atomic<uint32_t> next_begin = {0};
+    };
+}
@@ -0,0 +1,134 @@
+#include "tile_grid.hpp"
+#include "body.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace kin {
+    static uint32_t count_trailing_zeros(uint32_t bits) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, bits);
+        return (uint32_t)index;
+#else
+        return (uint32_t)__builtin_ctz(bits);
+#endif
+    }
+
+    tile_grid_t::tile_grid_t(rigid_body_t* body, const tile_grid_def_t& def)
+        : body(body), def(def) {
+        chunks_x = (def.width  + tile_chunk_size - 1) / tile_chunk_size;
+        chunks_y = (def.height + tile_chunk_size - 1) / tile_chunk_size;
+        chunks.resize(chunks_x * chunks_y);
+    }
+
+    tile_grid_t::~tile_grid_t() {
+        for(chunk_t& chunk : chunks) {
+            destroy_fixtures(chunk);
+        }
+    }
+
+    void tile_grid_t::destroy_fixtures(chunk_t& chunk) {
+        for(fixture_t* fixture : chunk.fixtures) {
+            fixture->grid_owned = false;
+            body->destroy_fixture(fixture);
+        }
+
+        rectangles -= (uint32_t)chunk.fixtures.size();
+        chunk.fixtures.clear();
+    }
+
+    void tile_grid_t::set_tile(uint32_t x, uint32_t y, bool solid) {
+        assert(x < def.width && y < def.height);
+
+        chunk_t& chunk = get_chunk(x, y);
+        uint16_t& row = chunk.rows[y % tile_chunk_size];
+        const uint16_t bit = (uint16_t)(1u << (x % tile_chunk_size));
+
+        if(((row & bit) != 0) == solid)
+            return;
+
+        row ^= bit;
+
+        if(!chunk.dirty) {
+            chunk.dirty = true;
+            dirty_chunks.push_back((uint32_t)(&chunk - chunks.data()));
+        }
+    }
+
+    bool tile_grid_t::get_tile(uint32_t x, uint32_t y) const {
+        assert(x < def.width && y < def.height);
+
+        return (get_chunk(x, y).rows[y % tile_chunk_size] >> (x % tile_chunk_size)) & 1u;
+    }
+
+    void tile_grid_t::update() {
+        for(uint32_t chunk_index : dirty_chunks) {
+            merge_chunk(chunk_index);
+        }
+
+        dirty_chunks.clear();
+    }
+
+    void tile_grid_t::merge_chunk(uint32_t chunk_index) {
+        chunk_t& chunk = chunks[chunk_index];
+        chunk.dirty = false;
+
+        destroy_fixtures(chunk);
+
+        const glm::vec2 chunk_corner = def.offset + glm::vec2(
+            (float)((chunk_index % chunks_x) * tile_chunk_size), 
+            (float)((chunk_index / chunks_x) * tile_chunk_size)) * def.tile_size;
+
+        fixture_def_t fixture_def;
+        fixture_def.density          = def.density;
+        fixture_def.restitution      = def.restitution;
+        fixture_def.static_friction  = def.static_friction;
+        fixture_def.dynamic_friction = def.dynamic_friction;
+
+        // a chunk never has more rectangles than a checkerboard of it
+        fixture_def_t fixture_defs[tile_chunk_size * tile_chunk_size / 2];
+        uint32_t count = 0;
+
+        // greedy merge: take the first run of solid tiles in the lowest row left,
+        // grow it down for as long as every row below has the whole run solid, 
+        // then clear the rectangle and repeat
+        uint16_t rows[tile_chunk_size];
+        std::copy(std::begin(chunk.rows), std::end(chunk.rows), rows);
+
+        for(uint32_t y = 0; y < tile_chunk_size; y++) {
+            while(rows[y] != 0) {
+                const uint32_t x = count_trailing_zeros(rows[y]);
+                // the run ends at the first empty tile after x
+                const uint32_t width = count_trailing_zeros(~((uint32_t)rows[y] >> x));
+                const uint16_t mask = (uint16_t)(((1u << width) - 1u) << x);
+
+                uint32_t height = 1;
+                while(y + height < tile_chunk_size && (rows[y + height] & mask) == mask) {
+                    height++;
+                }
+
+                for(uint32_t i = 0; i < height; i++) {
+                    rows[y + i] &= (uint16_t)~mask;
+                }
+
+                fixture_def.hw = (float)width  * def.tile_size * 0.5f;
+                fixture_def.hh = (float)height * def.tile_size * 0.5f;
+                fixture_def.rel_pos = chunk_corner + glm::vec2((float)x, (float)y) * def.tile_size + glm::vec2(fixture_def.hw, fixture_def.hh);
+
+                fixture_defs[count++] = fixture_def;
+            }
+        }
+
+        // all at once, so the mass of the body is only computed once
+        chunk.fixtures.resize(count);
+        body->create_fixtures(fixture_defs, count, chunk.fixtures.data());
+
+        for(fixture_t* fixture : chunk.fixtures) {
+            fixture->grid_owned = true;
+        }
+
+        rectangles += count;
+    }
+}
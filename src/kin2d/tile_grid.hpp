@@ -0,0 +1,77 @@
+#pragma once
+
+#include "fixture.hpp"
+
+namespace kin {
+    class rigid_body_t;
+
+    // tiles are merged per chunk, so editing a tile only re-merges its chunk
+    constexpr uint32_t tile_chunk_size = 16;
+
+    struct tile_grid_def_t {
+        uint32_t width  = 0;
+        uint32_t height = 0;
+        float tile_size = 1.0f;
+        // position of the corner of tile (0, 0) relative to the body
+        glm::vec2 offset = {0.0f, 0.0f};
+
+        float density = 1.0f;
+        float restitution = 0.0f;
+        float static_friction = 1.0f;
+        float dynamic_friction = 1.0f;
+    };
+
+    // a grid of solid or empty tiles attached to a rigid body. Solid tiles are
+    // greedily merged into as few rectangles as possible, and each rectangle becomes one fixture
+    class tile_grid_t {
+    public:
+        tile_grid_t(rigid_body_t* body, const tile_grid_def_t& def);
+        ~tile_grid_t();
+
+        // marks the tile's chunk dirty, nothing is re-merged until update
+        void set_tile(uint32_t x, uint32_t y, bool solid);
+        bool get_tile(uint32_t x, uint32_t y) const;
+
+        // re-merges every chunk that changed since the last update
+        void update();
+
+        const tile_grid_def_t& get_def() const { return def; }
+        uint32_t get_width() const { return def.width; }
+        uint32_t get_height() const { return def.height; }
+        // the number of fixtures the grid currently owns
+        uint32_t rectangle_count() const { return rectangles; }
+
+        // calls callback(fixture) for every fixture the grid owns
+        template<typename F>
+        void for_each_fixture(F&& callback) const {
+            for(const chunk_t& chunk : chunks) {
+                for(fixture_t* fixture : chunk.fixtures) {
+                    callback(fixture);
+                }
+            }
+        }
+
+    private:
+        struct chunk_t {
+            // one bit per tile, bit x of rows[y] is tile (x, y) of the chunk
+            uint16_t rows[tile_chunk_size] = {};
+            bool dirty = false;
+            std::vector<fixture_t*> fixtures;
+        };
+
+        chunk_t& get_chunk(uint32_t x, uint32_t y) { return chunks[(y / tile_chunk_size) * chunks_x + x / tile_chunk_size]; }
+        const chunk_t& get_chunk(uint32_t x, uint32_t y) const { return chunks[(y / tile_chunk_size) * chunks_x + x / tile_chunk_size]; }
+
+        void destroy_fixtures(chunk_t& chunk);
+        void merge_chunk(uint32_t chunk_index);
+
+        rigid_body_t* body;
+        tile_grid_def_t def;
+
+        uint32_t chunks_x = 0;
+        uint32_t chunks_y = 0;
+        uint32_t rectangles = 0;
+        std::vector<chunk_t> chunks;
+        std::vector<uint32_t> dirty_chunks;
+    };
+}
@@ -0,0 +1,90 @@
+#include "trace.hpp"
+#include <cstdio>
+
+namespace kin {
+    const char* step_phase_name(step_phase_t phase) {
+        switch(phase) {
+        case step_phase_integrate:   return "integrate";
+        case step_phase_vertices:    return "vertices";
+        case step_phase_broadphase:  return "broadphase";
+        case step_phase_pairs:       return "pairs";
+        case step_phase_narrowphase: return "narrowphase";
+        case step_phase_correction:  return "correction";
+        case step_phase_solve:       return "solve";
+        case step_phase_sleep:       return "sleep";
+        default:                     return "unknown";
+        }
+    }
+
+    step_profiler_t::step_profiler_t() 
+        : epoch(std::chrono::steady_clock::now()) {
+        set_thread_count(1);
+    }
+
+    void step_profiler_t::set_thread_count(uint32_t count) {
+        if(threads.size() >= count)
+            return;
+
+        threads.resize(count);
+
+        // nothing is recorded without KIN_PROFILE, so there is no need for the memory
+#if KIN_PROFILE
+        for(auto& events : threads) {
+            events.reserve(max_events_per_thread);
+        }
+#endif
+    }
+
+    uint64_t step_profiler_t::now_ns() const {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void step_profiler_t::record(uint32_t thread_index, step_phase_t phase, uint64_t start_ns, uint64_t end_ns, bool total) {
+        std::vector<trace_event_t>& events = threads[thread_index];
+        if(events.size() < events.capacity()) {
+            events.push_back({start_ns, end_ns, phase});
+        }
+
+        if(total) {
+            totals[phase] += end_ns - start_ns;
+        }
+    }
+
+    void step_profiler_t::take_totals(uint64_t (&phase_ns)[step_phase_count]) {
+        for(uint32_t i = 0; i < step_phase_count; i++) {
+            phase_ns[i] = totals[i];
+            totals[i]   = 0;
+        }
+    }
+
+    void step_profiler_t::clear() {
+        for(auto& events : threads) {
+            events.clear();
+        }
+    }
+
+    bool step_profiler_t::write_chrome_trace(const char* path) const {
+        FILE* file = fopen(path, "w");
+        if(file == nullptr)
+            return false;
+
+        fprintf(file, "{\"traceEvents\":[\n");
+
+        bool first = true;
+        for(size_t tid = 0; tid < threads.size(); tid++) {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%zu,\"args\":{\"name\":\"%s %zu\"}}", 
+                first ? "" : ",\n", tid, tid == 0 ? "main" : "worker", tid);
+            first = false;
+
+            for(const trace_event_t& event : threads[tid]) {
+                // timestamps are in microseconds
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+                    step_phase_name(event.phase), tid, (double)event.start_ns / 1000.0, (double)(event.end_ns - event.start_ns) / 1000.0);
+            }
+        }
+
+        fprintf(file, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+        return fclose(file) == 0;
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "base.hpp"
+
+// build with KIN_PROFILE=1 (the KIN_PROFILE cmake option) to time every phase of world_t::update,
+// without it the timers compile to nothing
+#ifndef KIN_PROFILE
+#define KIN_PROFILE 0
+#endif
+
+namespace kin {
+    enum step_phase_t: uint8_t {
+        step_phase_integrate = 0,
+        step_phase_vertices,    // fixture vertices, normals and boxes
+        step_phase_broadphase,  // keeping the broadphase up to date
+        step_phase_pairs,       // pair generation
+        step_phase_narrowphase,
+        step_phase_correction,  // position correction
+        step_phase_solve,       // the velocity solver, warm starting included
+        step_phase_sleep,       // islands and sleeping
+        step_phase_count
+    };
+
+    const char* step_phase_name(step_phase_t phase);
+
+    // what happened during a call to world_t::update, summed over every substep.
+    // Phase timings are only recorded when KIN_PROFILE is enabled
+    struct step_stats_t {
+        uint64_t phase_ns[step_phase_count] = {};
+        uint32_t substeps = 0;
+        uint32_t pairs    = 0;
+        uint32_t contacts = 0;
+    };
+
+    struct trace_event_t {
+        uint64_t     start_ns;
+        uint64_t     end_ns;
+        step_phase_t phase;
+    };
+
+    // records timed events into a buffer per thread, so that threads never share one
+    class step_profiler_t {
+    public:
+        // reserved up front for every thread, so that recording never allocates. 
+        // Events past this are dropped until clear is called, the totals are still kept
+        static constexpr size_t max_events_per_thread = 1 << 17;
+
+        step_profiler_t();
+
+        // every thread index passed to record must be below count, 
+        // must not be called while a thread may be recording
+        void set_thread_count(uint32_t count);
+
+        uint64_t now_ns() const;
+
+        // only thread 0 adds to the phase totals, events on other threads are parts of a phase
+        void record(uint32_t thread_index, step_phase_t phase, uint64_t start_ns, uint64_t end_ns, bool total);
+
+        // phase totals recorded since the last call, used for step_stats_t
+        void take_totals(uint64_t (&phase_ns)[step_phase_count]);
+
+        // drops every event recorded so far, keeping the memory for new ones
+        void clear();
+
+        // writes every event as a chrome trace, which can be opened in chrome://tracing or ui.perfetto.dev
+        bool write_chrome_trace(const char* path) const;
+
+    private:
+        std::chrono::steady_clock::time_point epoch;
+        std::vector<std::vector<trace_event_t>> threads;
+        uint64_t totals[step_phase_count] = {};
+    };
+
+    // times its own lifetime
+    class scoped_timer_t {
+    public:
+        // a whole phase on the calling thread
+        scoped_timer_t(step_profiler_t& profiler, step_phase_t phase)
+            : profiler(profiler), phase(phase), thread_index(0), total(true), start(profiler.now_ns()) {}
+
+        // a part of a phase running on one of the thread pool's threads
+        scoped_timer_t(step_profiler_t& profiler, step_phase_t phase, uint32_t thread_index)
+            : profiler(profiler), phase(phase), thread_index(thread_index), total(false), start(profiler.now_ns()) {}
+
+        ~scoped_timer_t() {
+            profiler.record(thread_index, phase, start, profiler.now_ns(), total);
+        }
+
+    private:
+        step_profiler_t& profiler;
+        step_phase_t     phase;
+        uint32_t         thread_index;
+        bool             total;
+        uint64_t         start;
+    };
+}
+
+#define KIN_PROFILE_CONCAT_INNER(a, b) a##b
+#define KIN_PROFILE_CONCAT(a, b) KIN_PROFILE_CONCAT_INNER(a, b)
+
+#if KIN_PROFILE
+#define KIN_PROFILE_SCOPE(profiler, phase) \
+    kin::scoped_timer_t KIN_PROFILE_CONCAT(kin_timer_, __LINE__)(profiler, phase)
+#define KIN_PROFILE_THREAD_SCOPE(profiler, phase, thread_index) \
+    kin::scoped_timer_t KIN_PROFILE_CONCAT(kin_timer_, __LINE__)(profiler, phase, thread_index)
+#else
+// still use the arguments, so that parameters only passed to them don't warn as unused
+#define KIN_PROFILE_SCOPE(profiler, phase) \
+    ((void)(profiler), (void)(phase))
+#define KIN_PROFILE_THREAD_SCOPE(profiler, phase, thread_index) \
+    ((void)(profiler), (void)(phase), (void)(thread_index))
+#endif
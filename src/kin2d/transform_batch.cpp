@@ -0,0 +1,158 @@
+#include "transform_batch.hpp"
+
+namespace kin {
+    // the corners of a box in the same order as fixture_t::update_vertices
+    static const float corner_x[4] = {-1.0f,  1.0f, 1.0f, -1.0f};
+    static const float corner_y[4] = {-1.0f, -1.0f, 1.0f,  1.0f};
+
+    static void transform_box_batch_scalar(box_batch_t& batch, uint32_t count) {
+        for(uint32_t lane = 0; lane < count; lane++) {
+            const float s = batch.sin[lane];
+            const float c = batch.cos[lane];
+
+            float min_x = float_max, min_y = float_max;
+            float max_x = -float_max, max_y = -float_max;
+
+            for(int i = 0; i < 4; i++) {
+                // get_world_point(local_vertex + pos)
+                const float px = ((corner_x[i] * batch.hw[lane]) + batch.pos_x[lane]) - batch.com_x[lane];
+                const float py = ((corner_y[i] * batch.hh[lane]) + batch.pos_y[lane]) - batch.com_y[lane];
+
+                const float x = ((px * c - py * s) + batch.com_x[lane]) + batch.body_x[lane];
+                const float y = ((px * s + py * c) + batch.com_y[lane]) + batch.body_y[lane];
+
+                batch.x[i][lane] = x;
+                batch.y[i][lane] = y;
+
+                min_x = x < min_x ? x : min_x;
+                max_x = x > max_x ? x : max_x;
+                min_y = y < min_y ? y : min_y;
+                max_y = y > max_y ? y : max_y;
+            }
+
+            // (-1, 0) and (0, -1) rotated
+            batch.nx[0][lane] = -1.0f * c - 0.0f * s;
+            batch.ny[0][lane] = -1.0f * s + 0.0f * c;
+            batch.nx[1][lane] = 0.0f * c - -1.0f * s;
+            batch.ny[1][lane] = 0.0f * s + -1.0f * c;
+
+            batch.min_x[lane] = min_x;
+            batch.min_y[lane] = min_y;
+            batch.max_x[lane] = max_x;
+            batch.max_y[lane] = max_y;
+        }
+    }
+
+#if KIN_X86
+    static void transform_box_batch_sse2(box_batch_t& batch, uint32_t count) {
+        const __m128 zero      = _mm_setzero_ps();
+        const __m128 minus_one = _mm_set1_ps(-1.0f);
+
+        for(uint32_t base = 0; base < count; base += 4) {
+            const __m128 s      = _mm_load_ps(&batch.sin[base]);
+            const __m128 c      = _mm_load_ps(&batch.cos[base]);
+            const __m128 hw     = _mm_load_ps(&batch.hw[base]);
+            const __m128 hh     = _mm_load_ps(&batch.hh[base]);
+            const __m128 pos_x  = _mm_load_ps(&batch.pos_x[base]);
+            const __m128 pos_y  = _mm_load_ps(&batch.pos_y[base]);
+            const __m128 com_x  = _mm_load_ps(&batch.com_x[base]);
+            const __m128 com_y  = _mm_load_ps(&batch.com_y[base]);
+            const __m128 body_x = _mm_load_ps(&batch.body_x[base]);
+            const __m128 body_y = _mm_load_ps(&batch.body_y[base]);
+
+            __m128 min_x = _mm_set1_ps(float_max), min_y = _mm_set1_ps(float_max);
+            __m128 max_x = _mm_set1_ps(-float_max), max_y = _mm_set1_ps(-float_max);
+
+            for(int i = 0; i < 4; i++) {
+                const __m128 px = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(corner_x[i]), hw), pos_x), com_x);
+                const __m128 py = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(corner_y[i]), hh), pos_y), com_y);
+
+                const __m128 x = _mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(px, c), _mm_mul_ps(py, s)), com_x), body_x);
+                const __m128 y = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, s), _mm_mul_ps(py, c)), com_y), body_y);
+
+                _mm_store_ps(&batch.x[i][base], x);
+                _mm_store_ps(&batch.y[i][base], y);
+
+                min_x = _mm_min_ps(x, min_x);
+                max_x = _mm_max_ps(x, max_x);
+                min_y = _mm_min_ps(y, min_y);
+                max_y = _mm_max_ps(y, max_y);
+            }
+
+            _mm_store_ps(&batch.nx[0][base], _mm_sub_ps(_mm_mul_ps(minus_one, c), _mm_mul_ps(zero, s)));
+            _mm_store_ps(&batch.ny[0][base], _mm_add_ps(_mm_mul_ps(minus_one, s), _mm_mul_ps(zero, c)));
+            _mm_store_ps(&batch.nx[1][base], _mm_sub_ps(_mm_mul_ps(zero, c), _mm_mul_ps(minus_one, s)));
+            _mm_store_ps(&batch.ny[1][base], _mm_add_ps(_mm_mul_ps(zero, s), _mm_mul_ps(minus_one, c)));
+
+            _mm_store_ps(&batch.min_x[base], min_x);
+            _mm_store_ps(&batch.min_y[base], min_y);
+            _mm_store_ps(&batch.max_x[base], max_x);
+            _mm_store_ps(&batch.max_y[base], max_y);
+        }
+    }
+
+    KIN_TARGET_AVX2
+    static void transform_box_batch_avx2(box_batch_t& batch, uint32_t) {
+        const __m256 zero      = _mm256_setzero_ps();
+        const __m256 minus_one = _mm256_set1_ps(-1.0f);
+
+        const __m256 s      = _mm256_load_ps(batch.sin);
+        const __m256 c      = _mm256_load_ps(batch.cos);
+        const __m256 hw     = _mm256_load_ps(batch.hw);
+        const __m256 hh     = _mm256_load_ps(batch.hh);
+        const __m256 pos_x  = _mm256_load_ps(batch.pos_x);
+        const __m256 pos_y  = _mm256_load_ps(batch.pos_y);
+        const __m256 com_x  = _mm256_load_ps(batch.com_x);
+        const __m256 com_y  = _mm256_load_ps(batch.com_y);
+        const __m256 body_x = _mm256_load_ps(batch.body_x);
+        const __m256 body_y = _mm256_load_ps(batch.body_y);
+
+        __m256 min_x = _mm256_set1_ps(float_max), min_y = _mm256_set1_ps(float_max);
+        __m256 max_x = _mm256_set1_ps(-float_max), max_y = _mm256_set1_ps(-float_max);
+
+        for(int i = 0; i < 4; i++) {
+            const __m256 px = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(corner_x[i]), hw), pos_x), com_x);
+            const __m256 py = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(corner_y[i]), hh), pos_y), com_y);
+
+            const __m256 x = _mm256_add_ps(_mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(px, c), _mm256_mul_ps(py, s)), com_x), body_x);
+            const __m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, s), _mm256_mul_ps(py, c)), com_y), body_y);
+
+            _mm256_store_ps(batch.x[i], x);
+            _mm256_store_ps(batch.y[i], y);
+
+            min_x = _mm256_min_ps(x, min_x);
+            max_x = _mm256_max_ps(x, max_x);
+            min_y = _mm256_min_ps(y, min_y);
+            max_y = _mm256_max_ps(y, max_y);
+        }
+
+        _mm256_store_ps(batch.nx[0], _mm256_sub_ps(_mm256_mul_ps(minus_one, c), _mm256_mul_ps(zero, s)));
+        _mm256_store_ps(batch.ny[0], _mm256_add_ps(_mm256_mul_ps(minus_one, s), _mm256_mul_ps(zero, c)));
+        _mm256_store_ps(batch.nx[1], _mm256_sub_ps(_mm256_mul_ps(zero, c), _mm256_mul_ps(minus_one, s)));
+        _mm256_store_ps(batch.ny[1], _mm256_add_ps(_mm256_mul_ps(zero, s), _mm256_mul_ps(minus_one, c)));
+
+        _mm256_store_ps(batch.min_x, min_x);
+        _mm256_store_ps(batch.min_y, min_y);
+        _mm256_store_ps(batch.max_x, max_x);
+        _mm256_store_ps(batch.max_y, max_y);
+    }
+#endif
+
+    void transform_box_batch(box_batch_t& batch, uint32_t count, simd_level_t level) {
+        assert(count <= box_batch_size);
+
+#if KIN_X86
+        if(level == simd_level_avx2) {
+            transform_box_batch_avx2(batch, count);
+            return;
+        }
+
+        if(level == simd_level_sse2) {
+            transform_box_batch_sse2(batch, count);
+            return;
+        }
+#endif
+
+        transform_box_batch_scalar(batch, count);
+    }
+}
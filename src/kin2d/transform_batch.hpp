@@ -0,0 +1,59 @@
+#pragma once
+
+#include "obb.hpp"
+#include "simd.hpp"
+
+namespace kin {
+    constexpr uint32_t box_batch_size = 8;
+
+    // fixtures laid out as structure of arrays for transform_box_batch, lane i
+    // of every array belongs to fixture i. Each lane carries its body's transform,
+    // so fixtures of different bodies can share a batch
+    struct alignas(32) box_batch_t {
+        // input
+        float pos_x[box_batch_size]; // fixture position relative to the body
+        float pos_y[box_batch_size];
+        float hw[box_batch_size];
+        float hh[box_batch_size];
+        float com_x[box_batch_size]; // the body's center of mass
+        float com_y[box_batch_size];
+        float body_x[box_batch_size];
+        float body_y[box_batch_size];
+        float sin[box_batch_size];
+        float cos[box_batch_size];
+
+        // output
+        float x[4][box_batch_size];
+        float y[4][box_batch_size];
+        float nx[2][box_batch_size];
+        float ny[2][box_batch_size];
+        float min_x[box_batch_size];
+        float min_y[box_batch_size];
+        float max_x[box_batch_size];
+        float max_y[box_batch_size];
+
+        // copies a lane's output into a collision proxy
+        void get(uint32_t lane, collision_proxy_t& proxy) const {
+            for(int i = 0; i < 4; i++) {
+                proxy.world_vertices[i] = {x[i][lane], y[i][lane]};
+            }
+
+            proxy.normals[0] = {nx[0][lane], ny[0][lane]};
+            proxy.normals[1] = {nx[1][lane], ny[1][lane]};
+
+            proxy.aabb.min[0] = min_x[lane];
+            proxy.aabb.min[1] = min_y[lane];
+            proxy.aabb.max[0] = max_x[lane];
+            proxy.aabb.max[1] = max_y[lane];
+        }
+    };
+
+    // computes world vertices, normals and tight boxes of count (at most box_batch_size) 
+    // fixtures. Follows fixture_t::update_vertices operation for operation, so every level 
+    // gives bitwise identical results as long as the compiler doesn't contract into fused multiply adds
+    void transform_box_batch(box_batch_t& batch, uint32_t count, simd_level_t level);
+
+    inline void transform_box_batch(box_batch_t& batch, uint32_t count) {
+        transform_box_batch(batch, count, get_simd_level());
+    }
+}
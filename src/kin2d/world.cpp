@@ -11,106 +11,759 @@ namespace kin {
     }
 
     world_t::~world_t() {
-        rigid_body_t* cur = dynamic_cast<rigid_body_t*>(bodies.first);
-        while(cur != nullptr) {
-            rigid_body_t* next = dynamic_cast<rigid_body_t*>(cur->next);
-
-            body_pool.destroy(cur, 1);
-
-            cur = next;
+        // destroying a body removes it from the store, 
+        // which moves the last body into its place
+        while(body_store.size() != 0) {
+            body_pool.destroy(body_store.bodies.back(), 1);
         }
     }
 
     rigid_body_t* world_t::create_rigid_body(glm::vec2 pos, float rot, body_type_t type) {
-        rigid_body_t* new_body = body_pool.create(1, this, pos, rot, type);
+        topology_version++;
+        return body_pool.create(1, this, &body_store, pos, rot, type);
+    }
+
+    void world_t::create_rigid_bodies(const body_def_t* defs, uint32_t count, rigid_body_t** bodies) {
+        topology_version++;
+        body_store.reserve(count);
 
-        bodies.push_back(new_body);
+        const bool outer_bulk = bulk_inserting;
+        if(!outer_bulk) {
+            begin_bulk_insert();
+        }
+
+        for(uint32_t i = 0; i < count; i++) {
+            const body_def_t& def = defs[i];
 
-        body_count++;
+            rigid_body_t* body = body_pool.create(1, this, &body_store, def.pos, def.rot, def.type);
+            body->create_fixtures(def.fixtures, def.fixture_count);
+
+            if(bodies != nullptr) {
+                bodies[i] = body;
+            }
+        }
 
-        return new_body;
+        if(!outer_bulk) {
+            end_bulk_insert();
+        }
     }
 
     void world_t::destroy_rigid_body(rigid_body_t* body) {
-        body_count--;
+        topology_version++;
+        body_pool.destroy(body, 1);
+    }
 
-        bodies.remove_element(body);
+    void world_t::integrate(float step) {
+        KIN_PROFILE_SCOPE(profiler, step_phase_integrate);
 
-        body_pool.destroy(body, 1);
+        const size_t count = body_store.size();
+
+        glm::vec2*   pos         = body_store.pos.data();
+        float*       psin        = body_store.psin.data();
+        float*       pcos        = body_store.pcos.data();
+        glm::vec2*   linear_vel  = body_store.linear_vel.data();
+        float*       angular_vel = body_store.angular_vel.data();
+        glm::vec2*   forces      = body_store.forces.data();
+        float*       torque      = body_store.torque.data();
+        const float* invmass     = body_store.invmass.data();
+        const float* invinertia  = body_store.invinertia.data();
+        const float*   motion    = body_store.motion.data();
+        const uint8_t* awake     = body_store.awake.data();
+
+        // static, massless and sleeping bodies have a motion of 0, 
+        // which keeps these loops free of branches
+        for(size_t i = 0; i < count; i++) {
+            const float mask = motion[i] * (float)awake[i];
+
+            linear_vel[i] += (gravity * step + step * invmass[i] * forces[i]) * mask;
+            pos[i]        += linear_vel[i] * step * mask;
+            forces[i]      = {0.0f, 0.0f};
+        }
+
+        // the rotation is turned by the angle moved this step to first order, then normalized 
+        // again. The error is in the order of the cube of the angle, which is tiny at any sane step
+        for(size_t i = 0; i < count; i++) {
+            const float mask = motion[i] * (float)awake[i];
+
+            angular_vel[i] += step * invinertia[i] * torque[i] * mask;
+            torque[i]       = 0.0f;
+
+            const float angle = angular_vel[i] * step;
+            const float sin   = psin[i] + angle * pcos[i];
+            const float cos   = pcos[i] - angle * psin[i];
+            const float inv_length = 1.0f / std::sqrt(sin * sin + cos * cos);
+
+            // bodies that don't move keep their rotation bit for bit
+            psin[i] = mask != 0.0f ? sin * inv_length : psin[i];
+            pcos[i] = mask != 0.0f ? cos * inv_length : pcos[i];
+        }
+    }
+
+    void world_t::compute_proxy_box(fixture_t* fixture, glm::vec2 displacement) {
+        rtree_element_t& relement = relement_pool[fixture->relement_id];
+        const aabb_t& aabb = proxies[fixture->relement_id].aabb;
+
+        // static fixtures never move, so they go into the static tree without any margin
+        if(fixture->body->is_static()) {
+            relement.min[0] = aabb.min[0];
+            relement.min[1] = aabb.min[1];
+            relement.max[0] = aabb.max[0];
+            relement.max[1] = aabb.max[1];
+            static_tree_dirty = true;
+            return;
+        }
+
+        const float margin = settings.aabb_margin;
+        for(int i = 0; i < 2; i++) {
+            relement.min[i] = aabb.min[i] - margin;
+            relement.max[i] = aabb.max[i] + margin;
+
+            // extend the box in the direction the fixture is moving in
+            if(displacement[i] < 0.0f) {
+                relement.min[i] += displacement[i];
+            } else {
+                relement.max[i] += displacement[i];
+            }
+        }
+    }
+
+    void world_t::insert_proxy(fixture_t* fixture, glm::vec2 displacement) {
+        compute_proxy_box(fixture, displacement);
+
+        if(fixture->body->is_static())
+            return;
+
+        if(bulk_inserting) {
+            bulk_ids.push_back((uint32_t)fixture->relement_id);
+            return;
+        }
+
+        broadphase->insert((uint32_t)fixture->relement_id, relement_pool[fixture->relement_id]);
+    }
+
+    void world_t::remove_proxy(fixture_t* fixture) {
+        if(fixture->body->is_static()) {
+            static_tree_dirty = true;
+        } else if(bulk_inserting) {
+            bulk_ids.erase(std::find(bulk_ids.begin(), bulk_ids.end(), (uint32_t)fixture->relement_id));
+        } else {
+            broadphase->remove((uint32_t)fixture->relement_id);
+        }
+
+        // the id will be reused, so its contacts must not be used for warm starting. 
+        // They are dropped all at once by the next update, destroying many fixtures 
+        // would go over the whole cache for every one of them otherwise
+        removed_ids.push_back((uint32_t)fixture->relement_id);
+    }
+
+    void world_t::drop_removed_contacts() {
+        if(removed_ids.empty())
+            return;
+
+        frame_vector_t<uint8_t> removed(arena);
+        removed.assign(proxies.size(), 0);
+        for(uint32_t id : removed_ids) {
+            removed[id] = 1;
+        }
+
+        contact_cache.erase(std::remove_if(contact_cache.begin(), contact_cache.end(), [&](const cached_contact_t& cached) {
+            return removed[cached.key >> 32] || removed[cached.key & 0xffffffff];
+        }), contact_cache.end());
+
+        removed_ids.clear();
     }
 
-    void world_t::solve_collisions_by_linear() {
-        iterate_bodies([&](kin::rigid_body_t* body) {
-            if(!body->has_fixtures())
+    bool world_t::synchronize_proxy(fixture_t* fixture, glm::vec2 sweep, glm::vec2 displacement) {
+        aabb_t swept = proxies[fixture->relement_id].aabb;
+        if(settings.speculative_contacts) {
+            for(int i = 0; i < 2; i++) {
+                swept.min[i] += glm::min(sweep[i], 0.0f);
+                swept.max[i] += glm::max(sweep[i], 0.0f);
+            }
+        }
+
+        if(aabb_contains(relement_pool[fixture->relement_id], swept))
+            return false;
+
+        // not remove_proxy, the fixture keeps its contacts
+        broadphase->remove((uint32_t)fixture->relement_id);
+        insert_proxy(fixture, displacement);
+        return true;
+    }
+
+    void world_t::refresh_proxies() {
+        proxies_stale = false;
+
+        for_each_body([&](kin::rigid_body_t* body) {
+            if(!body->has_fixtures() || body->is_static() || !body->is_awake())
                 return;
 
-            body->iterate_fixtures([&](fixture_t* fixture1){ 
-                rtree_element_t& relement = relement_pool[fixture1->relement_id];
+            body->for_each_fixture([&](fixture_t* fixture) {
+                fixture->update_vertices();
+                synchronize_proxy(fixture, {0.0f, 0.0f}, {0.0f, 0.0f});
+            });
+        });
+    }
+
+    void world_t::set_broadphase(broadphase_type_t type) {
+        if(broadphase->type() == type && broadphase->uses_current_settings())
+            return;
 
-                std::vector<rtree_element_t> results;
-                root.query(spatial::intersects<2>(relement.min, relement.max), std::back_inserter(results));
+        broadphase = create_broadphase(type, &thread_pool);
 
-                for(auto relement : results) {
-                    fixture_t& fixture2 = *(fixture_t*)relement.obb;
+        std::vector<uint32_t> ids;
+        std::vector<aabb_t>   boxes;
 
-                    if(fixture1->body == fixture2.body) {
-                        continue;
-                    }
-                    if(fixture1->body->is_static() && 
-                       fixture2.body->is_static()) {
+        for_each_body([&](kin::rigid_body_t* body) {
+            if(body->is_static())
+                return;
+
+            body->for_each_fixture([&](fixture_t* fixture) {
+                ids.push_back((uint32_t)fixture->relement_id);
+                boxes.push_back(relement_pool[fixture->relement_id]);
+            });
+        });
+
+        broadphase->insert_bulk(ids.data(), boxes.data(), (uint32_t)ids.size());
+    }
+
+    void world_t::begin_bulk_insert() {
+        assert(!bulk_inserting);
+        bulk_inserting = true;
+    }
+
+    void world_t::end_bulk_insert() {
+        assert(bulk_inserting);
+        bulk_inserting = false;
+
+        std::vector<aabb_t> boxes(bulk_ids.size());
+        for(size_t i = 0; i < bulk_ids.size(); i++) {
+            boxes[i] = relement_pool[bulk_ids[i]];
+        }
+
+        broadphase->insert_bulk(bulk_ids.data(), boxes.data(), (uint32_t)bulk_ids.size());
+
+        bulk_ids.clear();
+        bulk_ids.shrink_to_fit();
+    }
+
+    void world_t::build_static_tree() {
+        static_entries.clear();
+
+        for_each_body([&](kin::rigid_body_t* body) {
+            if(!body->is_static())
+                return;
+
+            body->for_each_fixture([&](fixture_t* fixture) {
+                static_entries.push_back({relement_pool[fixture->relement_id], (uint32_t)fixture->relement_id});
+            });
+        });
+
+        // build swaps the entries into the tree, leaving the old buffer here for the next build
+        static_tree.build(static_entries);
+        static_tree_dirty = false;
+    }
+
+    void world_t::generate_pairs() {
+        KIN_PROFILE_SCOPE(profiler, step_phase_pairs);
+
+        pairs.clear();
+
+        if(static_tree_dirty) {
+            build_static_tree();
+        }
+
+        // proxies of awake dynamic bodies, any pair with a static or sleeping body will be
+        // found through the awake body and pairs without an awake body are never solved
+        frame_vector_t<uint8_t> active(arena);
+        active.assign(proxies.size(), 0);
+
+        for_each_body([&](kin::rigid_body_t* body) {
+            if(!body->has_fixtures() || body->is_static() || !body->is_awake())
+                return;
+
+            body->for_each_fixture([&](fixture_t* fixture1) {
+                // speculative contacts need everything the fixture could reach this step, which the fattened box covers
+                const aabb_t& aabb = settings.speculative_contacts ? relement_pool[fixture1->relement_id] : proxies[fixture1->relement_id].aabb;
+                active[fixture1->relement_id] = 1;
+
+                // static fixtures are only in the static tree, so 
+                // static pairs are never even looked at
+                static_tree.query(aabb, [&](uint32_t id) {
+                    pairs.emplace_back(fixture1, (fixture_t*)relement_pool[id].obb);
+                });
+            });
+        });
+
+        broadphase->for_each_pair(active.data(), [&](uint32_t id1, uint32_t id2) {
+            fixture_t* fixture1 = (fixture_t*)relement_pool[id1].obb;
+            fixture_t* fixture2 = (fixture_t*)relement_pool[id2].obb;
+
+            if(fixture1->body == fixture2->body)
+                return;
+
+            // the broadphase compares fattened boxes, without speculative 
+            // contacts only pairs whose tight boxes touch can be in contact
+            if(!settings.speculative_contacts && !aabb_collide(proxies[id1].aabb, proxies[id2].aabb))
+                return;
+
+            pairs.emplace_back(fixture1, fixture2);
+        });
+
+        // the broadphase reports every pair once, sorting makes the order 
+        // independent of the backend, which warm starting depends on
+        std::sort(pairs.begin(), pairs.end());
+
+        stats.pairs += (uint32_t)pairs.size();
+    }
+
+    void world_t::narrowphase(float step) {
+        KIN_PROFILE_SCOPE(profiler, step_phase_narrowphase);
+
+        // grow along with the pair buffer, so that both reach their final size together
+        if(manifolds.capacity() < pairs.capacity()) {
+            manifolds.reserve(pairs.capacity());
+        }
+        manifolds.resize(pairs.size());
+
+        thread_pool.parallel_for((uint32_t)pairs.size(), 64, [&](uint32_t begin, uint32_t end, uint32_t thread_index) {
+            KIN_PROFILE_THREAD_SCOPE(profiler, step_phase_narrowphase, thread_index);
+
+            // zeroed so that the lanes a partial batch doesn't use still hold 
+            // finite values, the wider kernels compute them along with the rest
+            sat_batch_t        batch = {};
+            sat_batch_result_t result;
+            uint32_t           lanes[sat_batch_size];
+            uint32_t           count = 0;
+
+            // seperated boxes may still get a speculative contact if they are closing in on each other
+            auto speculate = [&](uint32_t i) {
+                if(!settings.speculative_contacts)
+                    return;
+
+                const fixture_pair_t& pair = pairs[i];
+                const glm::vec2 relative_vel = 
+                    body_store.linear_vel[pair.fixture2->body->index()] - body_store.linear_vel[pair.fixture1->body->index()];
+
+                speculative_collide(*pair.fixture1, *pair.fixture2, proxies[pair.fixture1->relement_id], proxies[pair.fixture2->relement_id], relative_vel, step, manifolds[i]);
+            };
+
+            auto flush = [&]() {
+                sat_test_batch(batch, count, result);
+
+                for(uint32_t lane = 0; lane < count; lane++) {
+                    if(!result.hit[lane]) {
+                        speculate(lanes[lane]);
                         continue;
                     }
 
-                    collision_manifold_t manifold;
-                    if(solve_collision_if_there(*fixture1, fixture2, manifold)) {
-                        impulse_method(*fixture1->body, *fixture2.body, manifold);
+                    const fixture_pair_t& pair = pairs[lanes[lane]];
+                    collision_manifold_t& manifold = manifolds[lanes[lane]];
+
+                    manifold.normal = {result.normal_x[lane], result.normal_y[lane]};
+                    manifold.depth  = result.depth[lane];
+                    compute_contact(*pair.fixture1, *pair.fixture2, proxies[pair.fixture1->relement_id], proxies[pair.fixture2->relement_id], manifold);
+                }
+
+                count = 0;
+            };
+
+            // pairs whose tight boxes overlap are packed into batches for the seperating axis test
+            for(uint32_t i = begin; i < end; i++) {
+                const collision_proxy_t& proxy1 = proxies[pairs[i].fixture1->relement_id];
+                const collision_proxy_t& proxy2 = proxies[pairs[i].fixture2->relement_id];
+
+                manifolds[i] = collision_manifold_t();
+                if(!aabb_collide(proxy1.aabb, proxy2.aabb)) {
+                    speculate(i);
+                    continue;
+                }
+
+                batch.set(count, proxy1, proxy2);
+                lanes[count++] = i;
+
+                if(count == sat_batch_size) {
+                    flush();
+                }
+            }
+
+            if(count != 0) {
+                flush();
+            }
+        });
+    }
+
+    void world_t::solve_contacts(float step) {
+        frame_vector_t<contact_constraint_t> constraints(arena);
+        constraints.reserve(pairs.size());
+
+        // waking and island edges are done up front, in pair order
+        for(uint32_t i = 0; i < (uint32_t)pairs.size(); i++) {
+            if(manifolds[i].count == 0)
+                continue;
+
+            rigid_body_t& body1 = *pairs[i].fixture1->body;
+            rigid_body_t& body2 = *pairs[i].fixture2->body;
+
+            // touching an awake body wakes a sleeping one
+            if(!body1.is_awake()) 
+                body1.wake();
+            if(!body2.is_awake()) 
+                body2.wake();
+
+            if(!body1.is_static() && !body2.is_static()) {
+                contact_edges.emplace_back(body1.index(), body2.index());
+            }
+
+            contact_constraint_t& constraint = constraints.emplace_back();
+            constraint.pair     = i;
+            constraint.key      = pairs[i].key;
+            constraint.body1    = body1.index();
+            constraint.body2    = body2.index();
+            constraint.dynamic1 = !body1.is_static();
+            constraint.dynamic2 = !body2.is_static();
+        }
+
+        // colored in pair order, so the batches come out the same on every thread count
+        constexpr uint32_t max_colors = max_contact_colors;
+
+        frame_vector_t<uint64_t> body_colors(body_store.size(), 0, arena);
+        frame_vector_t<uint8_t>  constraint_colors(constraints.size(), 0, arena);
+        color_contacts(constraints.data(), (uint32_t)constraints.size(), body_colors.data(), constraint_colors.data());
+
+        uint32_t color_offsets[max_colors + 2] = {};
+        for(size_t k = 0; k < constraints.size(); k++) {
+            color_offsets[constraint_colors[k] + 1]++;
+        }
+
+        // counting sort into one batch per color, keeping pair order within a batch
+        for(uint32_t color = 0; color < max_colors + 1; color++) {
+            color_offsets[color + 1] += color_offsets[color];
+        }
+
+        uint32_t fill[max_colors + 1];
+        std::copy(color_offsets, color_offsets + max_colors + 1, fill);
+
+        frame_vector_t<uint32_t> batches(constraints.size(), 0, arena);
+        for(uint32_t k = 0; k < (uint32_t)constraints.size(); k++) {
+            batches[fill[constraint_colors[k]]++] = k;
+        }
+
+        stats.contacts += (uint32_t)constraints.size();
+
+        // phase is only used to label the chunks run by each thread
+        auto for_each_color = [&](step_phase_t phase, auto&& fn) {
+            for(uint32_t color = 0; color < max_colors; color++) {
+                const uint32_t first = color_offsets[color];
+                const uint32_t count = color_offsets[color + 1] - first;
+
+                thread_pool.parallel_for(count, 32, [&](uint32_t begin, uint32_t end, uint32_t thread_index) {
+                    KIN_PROFILE_THREAD_SCOPE(profiler, phase, thread_index);
+
+                    for(uint32_t j = begin; j < end; j++) {
+                        fn(constraints[batches[first + j]]);
                     }
+                });
+            }
+
+            for(uint32_t j = color_offsets[max_colors]; j < color_offsets[max_colors + 1]; j++) {
+                fn(constraints[batches[j]]);
+            }
+        };
+
+        {
+            KIN_PROFILE_SCOPE(profiler, step_phase_correction);
+
+            // every manifold is found before any body moves, so a body resting on two boxes would 
+            // be pushed out of the same overlap twice. Each push is divided by the number of 
+            // contacts correcting that body instead
+            frame_vector_t<uint32_t> correction_counts(body_store.size(), 0, arena);
+            for(const contact_constraint_t& constraint : constraints) {
+                if(manifolds[constraint.pair].depth > 0.0f) {
+                    correction_counts[constraint.body1]++;
+                    correction_counts[constraint.body2]++;
                 }
+            }
+
+            for_each_color(step_phase_correction, [&](contact_constraint_t& constraint) {
+                const float share1 = 1.0f / (float)std::max(correction_counts[constraint.body1], 1u);
+                const float share2 = 1.0f / (float)std::max(correction_counts[constraint.body2], 1u);
+
+                correct_positions(*body_store.bodies[constraint.body1], *body_store.bodies[constraint.body2], manifolds[constraint.pair], share1, share2);
             });
+        }
+
+        KIN_PROFILE_SCOPE(profiler, step_phase_solve);
+
+        // only reads the bodies, so it doesn't need to go color by color
+        thread_pool.parallel_for((uint32_t)constraints.size(), 64, [&](uint32_t begin, uint32_t end, uint32_t thread_index) {
+            KIN_PROFILE_THREAD_SCOPE(profiler, step_phase_solve, thread_index);
+
+            for(uint32_t k = begin; k < end; k++) {
+                prepare_contact(constraints[k], manifolds[constraints[k].pair], body_store, step);
+            }
         });
+
+        // constraints are in pair order, which is key order
+        size_t cursor = 0;
+        for(contact_constraint_t& constraint : constraints) {
+            match_cached_contact(constraint, contact_cache, cursor);
+        }
+
+        for_each_color(step_phase_solve, [&](contact_constraint_t& constraint) {
+            warm_start_contact(constraint, body_store);
+        });
+
+        for(uint32_t i = 0; i < settings.velocity_iterations; i++) {
+            for_each_color(step_phase_solve, [&](contact_constraint_t& constraint) {
+                solve_contact(constraint, body_store);
+            });
+        }
+
+        // grow along with the pair buffer, so that both reach their final size together
+        if(next_contact_cache.capacity() < pairs.capacity()) {
+            next_contact_cache.reserve(pairs.capacity());
+        }
+
+        next_contact_cache.resize(constraints.size());
+        for(size_t k = 0; k < constraints.size(); k++) {
+            store_cached_contact(constraints[k], next_contact_cache[k]);
+        }
+
+        std::swap(contact_cache, next_contact_cache);
+    }
+
+    void world_t::solve_collisions_by_linear(float step) {
+        generate_pairs();
+        narrowphase(step);
+        solve_contacts(step);
+    }
+
+    void world_t::update_proxies(float step) {
+        // zeroed so that the lanes a partial batch doesn't use still hold finite values
+        box_batch_t batch = {};
+        fixture_t*  batch_fixtures[box_batch_size];
+        uint32_t    batch_count = 0;
+
+        // every updated fixture along with how far its body moves in one step
+        frame_vector_t<std::pair<fixture_t*, glm::vec2>> moved(arena);
+        moved.reserve(proxies.size());
+
+        auto flush = [&]() {
+            transform_box_batch(batch, batch_count);
+
+            for(uint32_t lane = 0; lane < batch_count; lane++) {
+                batch.get(lane, proxies[batch_fixtures[lane]->relement_id]);
+            }
+
+            batch_count = 0;
+        };
+
+        {
+            KIN_PROFILE_SCOPE(profiler, step_phase_vertices);
+
+            for(uint32_t i = 0; i < body_store.size(); i++) {
+                rigid_body_t* body = body_store.bodies[i];
+                if(!body->has_fixtures() || !body_store.awake[i] || body->is_static())
+                    continue;
+
+                // how far the body moves in one step
+                const glm::vec2 sweep = body_store.linear_vel[i] * step;
+
+                body->for_each_fixture([&](fixture_t* fixture){
+                    const uint32_t lane = batch_count++;
+
+                    batch.pos_x[lane]  = fixture->pos.x;
+                    batch.pos_y[lane]  = fixture->pos.y;
+                    batch.hw[lane]     = fixture->hw;
+                    batch.hh[lane]     = fixture->hh;
+                    batch.com_x[lane]  = body->center_of_mass.x;
+                    batch.com_y[lane]  = body->center_of_mass.y;
+                    batch.body_x[lane] = body_store.pos[i].x;
+                    batch.body_y[lane] = body_store.pos[i].y;
+                    batch.sin[lane]    = body_store.psin[i];
+                    batch.cos[lane]    = body_store.pcos[i];
+
+                    batch_fixtures[lane] = fixture;
+                    moved.emplace_back(fixture, sweep);
+
+                    if(batch_count == box_batch_size)
+                        flush();
+                });
+            }
+
+            if(batch_count > 0)
+                flush();
+        }
+
+        KIN_PROFILE_SCOPE(profiler, step_phase_broadphase);
+
+        // the tree holds fattened boxes, so a fixture only
+        // has to be reinserted once its tight box leaves it
+        for(const auto& [fixture, sweep] : moved) {
+            if(synchronize_proxy(fixture, sweep, sweep * settings.aabb_velocity_multiplier)) {
+                bp_stats.reinserted++;
+            } else {
+                bp_stats.untouched++;
+            }
+        }
     }
 
     void world_t::update(float delta_time, uint32_t iterations) {
         float step = delta_time / (float)iterations;
 
+        bp_stats = {};
+        stats    = {};
+        arena.reset();
+        contact_edges.clear();
+        profiler.set_thread_count(thread_pool.thread_count());
+        drop_removed_contacts();
+
         for(uint32_t i = 0; i < iterations; i++) {
-            root.clear();
+            integrate(step);
 
-            iterate_bodies([&](kin::rigid_body_t* body){
-                if(!body->has_fixtures())
-                    return;
+            update_proxies(step);
+
+            solve_collisions_by_linear(step);
+        }
 
-                body->apply_linear_velocity(gravity * step);
-                body->update(step);
+        update_sleep(delta_time);
 
-                body->iterate_fixtures([&](fixture_t* fixture){
-                    // Reinserting into quad tree
-                    // update_vertices() changes the AABB
-                    // so we must call it after removing the old AABB
-                    // from the tree
-                    fixture->update_vertices(); 
-                    root.insert(relement_pool[fixture->relement_id]);
-                });
+        // position correction moved bodies after their proxies were updated
+        proxies_stale = true;
+
+        stats.substeps = iterations;
+        profiler.take_totals(stats.phase_ns);
+
+        for(uint32_t i = 0; i < step_phase_count; i++) {
+            profile_ns[i] += stats.phase_ns[i];
+        }
+        profile_updates++;
+    }
+
+    static uint32_t find_island(frame_vector_t<uint32_t>& parent, uint32_t i) {
+        while(parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+
+        return i;
+    }
+
+    void world_t::update_sleep(float delta_time) {
+        if(!settings.allow_sleep)
+            return;
+
+        KIN_PROFILE_SCOPE(profiler, step_phase_sleep);
+
+        const uint32_t count = (uint32_t)body_store.size();
+        const float linear_tolerance  = sqaure(settings.sleep_linear_velocity);
+        const float angular_tolerance = settings.sleep_angular_velocity;
+
+        for(uint32_t i = 0; i < count; i++) {
+            if(body_store.motion[i] == 0.0f || !body_store.awake[i])
+                continue;
+
+            if(glm::length2(body_store.linear_vel[i]) > linear_tolerance ||
+               glm::abs(body_store.angular_vel[i]) > angular_tolerance) {
+                body_store.sleep_time[i] = 0.0f;
+            } else {
+                body_store.sleep_time[i] += delta_time;
+            }
+        }
+
+        // union find over the contact graph, static bodies never
+        // join islands as they would connect everything touching the ground
+        frame_vector_t<uint32_t> parent(count, 0, arena);
+        for(uint32_t i = 0; i < count; i++) {
+            parent[i] = i;
+        }
+
+        for(auto& edge : contact_edges) {
+            uint32_t root1 = find_island(parent, edge.first);
+            uint32_t root2 = find_island(parent, edge.second);
+
+            if(root1 != root2) {
+                parent[root2] = root1;
+            }
+        }
+
+        // an island can only sleep as soon as its most restless body can
+        frame_vector_t<float> island_sleep_time(count, float_max, arena);
+        for(uint32_t i = 0; i < count; i++) {
+            if(body_store.motion[i] == 0.0f || !body_store.awake[i])
+                continue;
+
+            float& sleep_time = island_sleep_time[find_island(parent, i)];
+            sleep_time = glm::min(sleep_time, body_store.sleep_time[i]);
+        }
+
+        // link every island that falls asleep into a circular list, so that
+        // waking any of its bodies wakes all of them
+        constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+        frame_vector_t<uint32_t> island_first(count, none, arena);
+        frame_vector_t<uint32_t> island_last(count, none, arena);
+        for(uint32_t i = 0; i < count; i++) {
+            if(body_store.motion[i] == 0.0f || !body_store.awake[i])
+                continue;
+
+            uint32_t root = find_island(parent, i);
+            if(island_sleep_time[root] < settings.time_to_sleep)
+                continue;
+
+            body_store.awake[i]       = 0;
+            body_store.linear_vel[i]  = {0.0f, 0.0f};
+            body_store.angular_vel[i] = 0.0f;
+
+            // position correction doesn't update fixtures, so they have to 
+            // be brought up to date before the body stops being updated
+            body_store.bodies[i]->for_each_fixture([&](fixture_t* fixture) {
+                fixture->update_vertices();
+                synchronize_proxy(fixture, {0.0f, 0.0f}, {0.0f, 0.0f});
             });
 
-            solve_collisions_by_linear();
+            if(island_first[root] == none) {
+                island_first[root] = i;
+            } else {
+                body_store.island_next[island_last[root]] = body_store.ids[i];
+            }
+
+            island_last[root] = i;
+        }
+
+        for(uint32_t root = 0; root < count; root++) {
+            if(island_first[root] != none) {
+                body_store.island_next[island_last[root]] = body_store.ids[island_first[root]];
+            }
         }
     }
 
     size_t world_t::count() {
-        return body_count;
+        return body_store.size();
     }
 
     void world_t::iterate_bodies(body_callback_t callback) {
-        rigid_body_t* cur = dynamic_cast<rigid_body_t*>(bodies.first);
-        while(cur != nullptr) {
-            callback(cur);
-
-            cur = dynamic_cast<rigid_body_t*>(cur->next);
-        }
+        for_each_body(callback);
     }
 
     void world_t::set_gravity(glm::vec2 gravity) {
         this->gravity = gravity;
     }
+
+    void world_t::print_profiles(int denom) {
+        const uint32_t called = denom != -1 ? (uint32_t)denom : profile_updates;
+
+        if(called != 0) {
+            for(uint32_t i = 0; i < step_phase_count; i++) {
+                printf("#%s : %fus\n", step_phase_name((step_phase_t)i), (float)profile_ns[i] / 1000.0f / (float)called);
+            }
+        }
+
+        std::fill(std::begin(profile_ns), std::end(profile_ns), 0);
+        profile_updates = 0;
+    }
+
+    void world_t::set_worker_count(uint32_t count) {
+        thread_pool.set_worker_count(count);
+    }
 }
\ No newline at end of file
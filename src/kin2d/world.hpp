@@ -1,10 +1,50 @@
 #pragma once
 
 #include "body.hpp"
+#include "solver.hpp"
+#include "sat_batch.hpp"
+#include "transform_batch.hpp"
+#include "static_tree.hpp"
+#include "broadphase.hpp"
+#include "settings.hpp"
+#include "arena.hpp"
+#include "thread_pool.hpp"
+#include "trace.hpp"
+#include "snapshot.hpp"
+#include "scene.hpp"
+#include "query.hpp"
 
 namespace kin {
     typedef std::function<void(kin::rigid_body_t* body)> body_callback_t;
 
+    // how many broadphase proxies had to be reinserted during the last
+    // call to world_t::update and how many could stay where they were
+    struct broadphase_stats_t {
+        uint32_t reinserted = 0;
+        uint32_t untouched  = 0;
+    };
+
+    // a pair of fixtures whose broadphase boxes overlap, the fixture
+    // with the lower relement id is always fixture1
+    struct fixture_pair_t {
+        fixture_pair_t(fixture_t* a, fixture_t* b) {
+            if(a->relement_id > b->relement_id) {
+                std::swap(a, b);
+            }
+
+            fixture1 = a;
+            fixture2 = b;
+            key = ((uint64_t)(uint32_t)a->relement_id << 32) | (uint64_t)(uint32_t)b->relement_id;
+        }
+
+        bool operator<(const fixture_pair_t& other) const { return key < other.key; }
+        bool operator==(const fixture_pair_t& other) const { return key == other.key; }
+
+        uint64_t   key;
+        fixture_t* fixture1;
+        fixture_t* fixture2;
+    };
+
     class world_t {
         friend class rigid_body_t;
 
@@ -16,6 +56,11 @@ namespace kin {
         // create a rigid body
         rigid_body_t* create_rigid_body(glm::vec2 pos, float rot, body_type_t type);
 
+        // creates count bodies along with their fixtures, computing the mass of each body once and
+        // putting every dynamic fixture into the broadphase in one go. Much faster than creating
+        // them one by one when loading a level. If bodies is not null it receives the new bodies
+        void create_rigid_bodies(const body_def_t* defs, uint32_t count, rigid_body_t** bodies = nullptr);
+
         // destroy a rigid body
         void destroy_rigid_body(rigid_body_t* body);
 
@@ -25,39 +70,184 @@ namespace kin {
         // iterate through all bodies using a function
         void iterate_bodies(body_callback_t callback);
 
+        // same as iterate_bodies, but the callback is called directly
+        // so it can be inlined. Prefer this in anything that runs every step
+        template<typename F>
+        void for_each_body(F&& callback) {
+            for(size_t i = 0; i < body_store.size(); i++) {
+                callback(body_store.bodies[i]);
+            }
+        }
+
         // get the last body created
         // for debug purposes
-        rigid_body_t* last_body() { return dynamic_cast<rigid_body_t*>(bodies.last); }
+        rigid_body_t* last_body() { return body_store.size() == 0 ? nullptr : body_store.bodies.back(); }
 
         // the amount of bodies in the world
         size_t count();
 
-        // print profile
+        // prints the average time of every step phase since the last call, divided by denom 
+        // instead of the amount of updates if it isn't -1. Needs KIN_PROFILE
         void print_profiles(int denom = -1);
 
         // set gravity
         void set_gravity(glm::vec2 gravity);
 
+        // the amount of extra threads used for parallel parts of the step, 0 by default.
+        // Results do not depend on the amount of threads
+        void set_worker_count(uint32_t count);
+
+        // moves every dynamic proxy into a new broadphase of the given type, 
+        // the rtree by default. Results do not depend on the broadphase. Also 
+        // applies changes to the grid settings when called with the current type
+        void set_broadphase(broadphase_type_t type);
+        broadphase_type_t get_broadphase_type() const { return broadphase->type(); }
+
         // relement getter
         rtree_element_t& relement(int id) { return relement_pool[id]; }
 
+        // collision proxy getter, proxies share their id with the relement
+        collision_proxy_t& proxy(int id) { return proxies[id]; }
+
+        // broadphase stats of the last update
+        const broadphase_stats_t& get_broadphase_stats() const { return bp_stats; }
+
+        // phase timings, pair and contact counts of the last update
+        const step_stats_t& get_step_stats() const { return stats; }
+
+        // writes every phase recorded since the last clear_trace, 
+        // on every thread, as a chrome trace. Needs KIN_PROFILE
+        bool write_chrome_trace(const char* path) const { return profiler.write_chrome_trace(path); }
+        void clear_trace() { profiler.clear(); }
+
+        // the number of bytes save_snapshot needs for the world as it is right now
+        size_t snapshot_size() const;
+
+        // copies everything update reads and writes into buffer: the body store, collision proxies,
+        // broadphase boxes and contact cache. Returns the number of bytes written, 0 if size is too small
+        size_t save_snapshot(void* buffer, size_t size) const;
+
+        // puts the world back into the state it was in when the snapshot was taken, updating after 
+        // this gives bitwise identical results. Fails and leaves the world untouched if bodies or 
+        // fixtures were created, destroyed or had their density changed since then
+        bool restore_snapshot(const void* buffer, size_t size);
+
+        // appends every body, fixture and tile grid in the world to data as a scene, see scene.hpp
+        void save_scene(std::vector<uint8_t>& data);
+        bool save_scene(const char* path);
+
+        // creates every body in the scene on top of the bodies already in the world. 
+        // Fails without creating anything if data is not a valid scene of a known version
+        bool load_scene(const void* data, size_t size);
+        // maps the file into memory and loads it
+        bool load_scene(const char* path);
+
+        // batched queries against every fixture in the world, static or dynamic, tested against the
+        // exact shape of the fixture. Large batches are split across the thread pool, and nothing
+        // is allocated. The results of query i start at results[i * max_results] and are sorted by 
+        // fixture id, counts[i] is how many fixtures were found. When that is more than max_results 
+        // only the lowest ids are written
+
+        // fixtures overlapping boxes[i]
+        void query_aabbs(const aabb_t* boxes, uint32_t count, fixture_t** results, uint32_t max_results, uint32_t* counts);
+        // fixtures containing points[i]
+        void query_points(const glm::vec2* points, uint32_t count, fixture_t** results, uint32_t max_results, uint32_t* counts);
+        // the first fixture along rays[i], hits[i].fixture is null if there is none. 
+        // A ray that starts inside a fixture doesn't hit that fixture
+        void raycast_closest(const ray_t* rays, uint32_t count, raycast_hit_t* hits);
+        // every fixture along rays[i] starting at hits[i * max_hits], closest first.
+        // When more than max_hits are found only the closest are written
+        void raycast_all(const ray_t* rays, uint32_t count, raycast_hit_t* hits, uint32_t max_hits, uint32_t* counts);
+
+        // a hash of every body's position, rotation, velocities and sleep state, 
+        // equal on every machine that is in sync. Compare these to detect desyncs
+        uint64_t state_hash() const;
+
     private:
-        void solve_collisions_by_linear();
+        // computes the fattened box of a fixture and inserts it into the tree
+        void insert_proxy(fixture_t* fixture, glm::vec2 displacement);
+        // only computes the fattened box
+        void compute_proxy_box(fixture_t* fixture, glm::vec2 displacement);
+        void remove_proxy(fixture_t* fixture);
+        // removes the cached contacts of every proxy removed since the last update
+        void drop_removed_contacts();
+        // reinserts the fixture only when it has left its fattened box, returns whether it was.
+        // With speculative contacts the box swept by sweep has to stay inside the fattened box
+        bool synchronize_proxy(fixture_t* fixture, glm::vec2 sweep, glm::vec2 displacement);
+        // brings the proxies of every awake dynamic body up to date with where the body is now
+        void refresh_proxies();
+        // recomputes the vertices, normals and boxes of every fixture on an awake body
+        // eight at a time, writing straight into the proxies, then synchronizes the tree
+        void update_proxies(float step);
+
+        // while bulk inserting, dynamic proxies are collected and 
+        // given to the broadphase all at once by end_bulk_insert
+        void begin_bulk_insert();
+        void end_bulk_insert();
+
+        // packs every static fixture into the static tree
+        void build_static_tree();
+        // brings the static tree and broadphase up to date so both can be queried from several threads
+        void prepare_queries();
+        // fills pairs with every unique overlapping fixture pair, sorted by key
+        void generate_pairs();
+        // fills manifolds[i] for pairs[i], runs across the thread pool
+        void narrowphase(float step);
+        // colors the touching pairs so that no two pairs of the same color share 
+        // a dynamic body, then runs the sequential impulse solver one color at a time
+        // across the thread pool
+        void solve_contacts(float step);
+        void solve_collisions_by_linear(float step);
         void solve_collisions_by_leaf();
 
-        size_t body_count = 0;
+        // applies gravity and forces, then moves every awake body in the body store
+        void integrate(float step);
 
-        profiler_t profiler;
-        float dt_total          = 0.0f;
-        float clean_every       = 0.25f;
+        // builds islands out of the bodies that touched during the last update,
+        // and puts every island that has been resting long enough to sleep
+        void update_sleep(float delta_time);
 
-        ptm::doubly_linked_list_header_t<rigid_body_t> bodies;
+        step_profiler_t profiler;
+        step_stats_t    stats;
+        // phase times summed over every update since the last print_profiles
+        uint64_t profile_ns[step_phase_count] = {};
+        uint32_t profile_updates = 0;
+
+        body_store_t body_store;
 
         ptm::object_pool_t<rigid_body_t>  body_pool = {1000};
         ptm::object_pool_t<fixture_t>     fixture_pool = {1000};
         ptm::free_list_t<rtree_element_t> relement_pool;
-
-        spatial::RTree<float, rtree_element_t, 2> root;
+        std::vector<collision_proxy_t>    proxies;
+
+        // only holds fixtures of dynamic bodies, static fixtures live in static_tree
+        std::unique_ptr<broadphase_t> broadphase = create_broadphase(broadphase_type_rtree, &thread_pool);
+        static_tree_t static_tree;
+        std::vector<static_tree_t::entry_t> static_entries;
+        // set when a static fixture is created, destroyed or moved, the tree is rebuilt before the next query
+        bool static_tree_dirty = false;
+        // set when dynamic bodies may have moved since their proxies were computed, by position
+        // correction or a teleport. The proxies are refreshed before the next query
+        bool proxies_stale = false;
+        broadphase_stats_t bp_stats;
+        bool bulk_inserting = false;
+        std::vector<uint32_t> bulk_ids;
+        std::vector<fixture_pair_t> pairs;
+        std::vector<collision_manifold_t> manifolds;
+        // the impulses of last step's contacts sorted by pair key, used for warm starting
+        std::vector<cached_contact_t> contact_cache;
+        std::vector<cached_contact_t> next_contact_cache;
+        // ids of proxies removed since the last update, whose cached contacts have yet to be dropped
+        std::vector<uint32_t> removed_ids;
+        // dynamic body indices that were in contact during the last update
+        std::vector<std::pair<uint32_t, uint32_t>> contact_edges;
+
+        // changed whenever a snapshot could no longer be restored: bodies or fixtures being created or destroyed, or mass changing
+        uint64_t topology_version = 0;
+
+        // scratch memory for a single call to update
+        frame_arena_t arena;
+        thread_pool_t thread_pool;
         glm::vec2 gravity = {ptm::blatent_f, ptm::blatent_f};
     };
 }
\ No newline at end of file
@@ -1,37 +1,1185 @@
 #include <kin2d/kin2d.hpp>
-#include <kin2d/math.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <new>
 
-int main() {
-    kin::print_test();
+// counts global heap allocations while enabled, used to make sure 
+// world_t::update doesn't touch the heap once it has warmed up
+static bool   count_allocations = false;
+static size_t allocation_count  = 0;
+
+void* operator new(size_t size) {
+    if(count_allocations)
+        allocation_count++;
+
+    void* ptr = malloc(size);
+    if(ptr == nullptr)
+        throw std::bad_alloc();
+
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+// boxes bouncing around a closed room without gravity, so that every counted update
+// integrates, reinserts and collides moving bodies
+int test_update_allocations(kin::broadphase_type_t type) {
+    kin::world_t world({0.0f, 0.0f});
+    world.set_broadphase(type);
+
+    kin::fixture_def_t wall_def;
+    wall_def.hw = 20.0f;
+    wall_def.hh = 1.0f;
+
+    kin::rigid_body_t* walls = world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_static);
+    wall_def.rel_pos = {0.0f, -20.0f};
+    walls->create_fixture(wall_def);
+    wall_def.rel_pos = {0.0f, 20.0f};
+    walls->create_fixture(wall_def);
+
+    wall_def.hw  = 1.0f;
+    wall_def.hh  = 20.0f;
+    wall_def.rel_pos = {-20.0f, 0.0f};
+    walls->create_fixture(wall_def);
+    wall_def.rel_pos = {20.0f, 0.0f};
+    walls->create_fixture(wall_def);
+
+    kin::fixture_def_t box_def;
+    box_def.hw = 0.4f;
+    box_def.hh = 0.4f;
+    box_def.restitution = 1.0f;
+    box_def.static_friction  = 0.0f;
+    box_def.dynamic_friction = 0.0f;
+
+    std::vector<kin::rigid_body_t*> boxes;
+    for(int i = 0; i < 200; i++) {
+        glm::vec2 pos = {(float)(i % 20) * 1.8f - 17.0f, (float)(i / 20) * 1.8f - 8.0f};
+        kin::rigid_body_t* box = world.create_rigid_body(pos, 0.0f, kin::body_type_dynamic);
+        box->create_fixture(box_def);
+        box->apply_linear_velocity({(float)(i * 7 % 11) - 5.0f, (float)(i * 5 % 13) - 6.0f + 0.5f});
+        boxes.push_back(box);
+    }
+
+    // warm up, lets every persistent buffer reach its final size
+    for(int i = 0; i < 120; i++) {
+        world.update(0.016f, 8);
+    }
+
+    allocation_count  = 0;
+    count_allocations = true;
+    for(int i = 0; i < 60; i++) {
+        world.update(0.016f, 8);
+    }
+    count_allocations = false;
+
+    // the counted updates have to have had something to do
+    int moving = 0;
+    for(kin::rigid_body_t* box : boxes) {
+        if(box->is_awake() && glm::length(box->linear_vel()) > 0.5f) {
+            moving++;
+        }
+    }
+
+    printf("heap allocations during update with broadphase %d: %zu, %d of %zu boxes moving\n", (int)type, allocation_count, moving, boxes.size());
+
+    return allocation_count == 0 && moving > (int)boxes.size() / 2 ? 0 : 1;
+}
+
+// a body that stays inside its fattened box is left alone, one that leaves it is reinserted
+int test_broadphase_stats() {
+    kin::world_t world({0.0f, 0.0f});
+
+    kin::rigid_body_t* slow = world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_dynamic);
+    slow->create_fixture(kin::fixture_def_t());
+    slow->apply_linear_velocity({1.0f, 0.0f});
+
+    kin::rigid_body_t* fast = world.create_rigid_body({0.0f, 10.0f}, 0.0f, kin::body_type_dynamic);
+    fast->create_fixture(kin::fixture_def_t());
+    fast->apply_linear_velocity({100.0f, 0.0f});
+
+    world.update(0.016f, 1);
+
+    const kin::broadphase_stats_t& stats = world.get_broadphase_stats();
+    if(stats.untouched != 1 || stats.reinserted != 1) {
+        printf("broadphase stats are wrong, %u untouched and %u reinserted\n", stats.untouched, stats.reinserted);
+        return 1;
+    }
+
+    return 0;
+}
+
+// a resting stack falls asleep as one island, and waking any part of it wakes all of it
+int test_sleep() {
+    kin::world_t world;
+
+    kin::fixture_def_t ground_def;
+    ground_def.hw = 20.0f;
+    world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_static)->create_fixture(ground_def);
+
+    kin::rigid_body_t* stack[3];
+    for(int i = 0; i < 3; i++) {
+        stack[i] = world.create_rigid_body({0.0f, 2.0f + (float)i * 2.0f}, 0.0f, kin::body_type_dynamic);
+        stack[i]->create_fixture(kin::fixture_def_t());
+    }
+
+    auto island_is = [&](bool awake) {
+        for(kin::rigid_body_t* body : stack) {
+            if(body->is_awake() != awake)
+                return false;
+        }
+
+        return true;
+    };
+
+    for(int i = 0; i < 300; i++) {
+        world.update(0.016f, 8);
+    }
+
+    if(!island_is(false)) {
+        printf("a resting stack did not fall asleep\n");
+        return 1;
+    }
+
+    stack[0]->wake();
+    if(!island_is(true)) {
+        printf("waking the bottom of a stack did not wake the rest of it\n");
+        return 1;
+    }
+
+    for(int i = 0; i < 300; i++) {
+        world.update(0.016f, 8);
+    }
 
-    // testing cos, sin, tan speed
-    kin::profiler_t trig;
-    int sinid = trig.create_profile("sin");
-    int cosid = trig.create_profile("cos");
-    int tanid = trig.create_profile("rot");
-    size_t test_size = 100;
+    if(!island_is(false)) {
+        printf("a woken stack did not fall back asleep\n");
+        return 1;
+    }
 
-    for(size_t i = 0; i < test_size; i++) {
-        trig.start_profile(sinid);
-        volatile float imanop = kin::fast_sin(glm::radians((float)(i % 360)));
-        trig.end_profile(sinid);
+    // a box landing on top has to wake the whole stack, not just the box it lands on
+    world.create_rigid_body({0.0f, 9.0f}, 0.0f, kin::body_type_dynamic)->create_fixture(kin::fixture_def_t());
+    for(int i = 0; i < 30 && !stack[2]->is_awake(); i++) {
+        world.update(0.016f, 8);
     }
 
-    for(size_t i = 0; i < test_size; i++) {
-        trig.start_profile(cosid);
-        volatile float imanop = kin::fast_cos(glm::radians((float)(i % 360)));
-        trig.end_profile(cosid);
+    if(!island_is(true)) {
+        printf("a contact did not wake the whole stack\n");
+        return 1;
     }
 
-    for(size_t i = 0; i < test_size; i++) {
-        trig.start_profile(tanid);
-        volatile glm::vec2 imanop = kin::fast_rotate({1.0f, 0.0f}, glm::radians((float)(i % 360)));
-        trig.end_profile(tanid);
+    return 0;
+}
+
+// the same scene with every broadphase and several worker counts, the results have to be identical
+int test_worker_counts() {
+    const kin::broadphase_type_t types[] = {kin::broadphase_type_rtree, kin::broadphase_type_sap, kin::broadphase_type_grid};
+    const uint32_t worker_counts[] = {0, 1, 3, 7};
+
+    uint64_t expected_hash = 0;
+    for(int t = 0; t < 3; t++) {
+        for(int w = 0; w < 4; w++) {
+            kin::world_t world;
+            world.set_broadphase(types[t]);
+            world.set_worker_count(worker_counts[w]);
+
+            kin::fixture_def_t ground_def;
+            ground_def.hw = 100.0f;
+            world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_static)->create_fixture(ground_def);
+
+            for(int i = 0; i < 200; i++) {
+                glm::vec2 pos = {(float)(i % 20) * 2.2f - 22.0f, 3.0f + (float)(i / 20) * 2.5f};
+                kin::rigid_body_t* body = world.create_rigid_body(pos, 0.1f * (float)i, kin::body_type_dynamic);
+                body->create_fixture(kin::fixture_def_t());
+                body->apply_linear_velocity({(float)(i % 5) - 2.0f, 0.0f});
+            }
 
-        // printf("imanop %f %f\n", imanop.x, imanop.y);
+            for(int i = 0; i < 60; i++) {
+                world.update(0.016f, 8);
+            }
+
+            if(t == 0 && w == 0) {
+                expected_hash = world.state_hash();
+            } else if(world.state_hash() != expected_hash) {
+                printf("broadphase %d with %u workers gave different results\n", t, worker_counts[w]);
+                return 1;
+            }
+        }
     }
 
-    trig.print_profiles(-1);
+    return 0;
+}
+
+// a box pushed out of two boxes at once along the same normal moves as 
+// far as one pushed out of a single box, not twice as far
+int test_position_correction() {
+    kin::world_t world({0.0f, 0.0f});
+
+    kin::fixture_def_t wide_def;
+    wide_def.hw = 2.0f;
+    world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_static)->create_fixture(wide_def);
+    world.create_rigid_body({10.0f, 0.0f}, 0.0f, kin::body_type_static)->create_fixture(kin::fixture_def_t());
+    world.create_rigid_body({12.0f, 0.0f}, 0.0f, kin::body_type_static)->create_fixture(kin::fixture_def_t());
+
+    // both sink 0.2 into what is below them
+    kin::rigid_body_t* single = world.create_rigid_body({0.0f, 1.8f}, 0.0f, kin::body_type_dynamic);
+    single->create_fixture(kin::fixture_def_t());
+    kin::rigid_body_t* spanning = world.create_rigid_body({11.0f, 1.8f}, 0.0f, kin::body_type_dynamic);
+    spanning->create_fixture(kin::fixture_def_t());
+
+    world.update(0.016f, 1);
+
+    const float single_rise   = single->pos().y - 1.8f;
+    const float spanning_rise = spanning->pos().y - 1.8f;
+    if(single_rise <= 0.0f || std::abs(spanning_rise - single_rise) > 1e-4f) {
+        printf("a box on two boxes rose %g, on one box %g\n", spanning_rise, single_rise);
+        return 1;
+    }
+
+    return 0;
+}
+
+// no two constraints of the same color may share a dynamic body, and
+// constraints past the last color are left for the sequential fallback
+int test_contact_coloring() {
+    const uint32_t body_count = 50;
+
+    std::vector<kin::contact_constraint_t> constraints(2000);
+    uint32_t seed = 1;
+    for(kin::contact_constraint_t& constraint : constraints) {
+        seed = seed * 1664525u + 1013904223u;
+        constraint.body1    = (seed >> 8) % body_count;
+        constraint.body2    = (constraint.body1 + 1 + (seed >> 20) % (body_count - 1)) % body_count;
+        // the first few bodies are static
+        constraint.dynamic1 = constraint.body1 >= 5;
+        constraint.dynamic2 = constraint.body2 >= 5;
+    }
+
+    std::vector<uint64_t> body_colors(body_count, 0);
+    std::vector<uint8_t>  colors(constraints.size());
+    kin::color_contacts(constraints.data(), (uint32_t)constraints.size(), body_colors.data(), colors.data());
+
+    for(uint32_t color = 0; color < kin::max_contact_colors; color++) {
+        std::vector<uint8_t> used(body_count, 0);
+
+        for(size_t k = 0; k < constraints.size(); k++) {
+            if(colors[k] != color)
+                continue;
+
+            const kin::contact_constraint_t& constraint = constraints[k];
+            if((constraint.dynamic1 && used[constraint.body1]++) || (constraint.dynamic2 && used[constraint.body2]++)) {
+                printf("two constraints of color %u share a body\n", color);
+                return 1;
+            }
+        }
+    }
+
+    // a body touching more boxes than there are colors, everything past the last color falls back
+    std::vector<kin::contact_constraint_t> fan(kin::max_contact_colors + 6);
+    for(uint32_t k = 0; k < (uint32_t)fan.size(); k++) {
+        fan[k].body1    = 0;
+        fan[k].body2    = k + 1;
+        fan[k].dynamic1 = true;
+        fan[k].dynamic2 = true;
+    }
+
+    std::vector<uint64_t> fan_body_colors(fan.size() + 1, 0);
+    std::vector<uint8_t>  fan_colors(fan.size());
+    kin::color_contacts(fan.data(), (uint32_t)fan.size(), fan_body_colors.data(), fan_colors.data());
+
+    for(uint32_t k = 0; k < (uint32_t)fan.size(); k++) {
+        if(fan_colors[k] != std::min(k, kin::max_contact_colors)) {
+            printf("constraint %u of a fan got color %u\n", k, fan_colors[k]);
+            return 1;
+        }
+    }
+
+    // a box resting on more boxes than there are colors still has to be held up
+    kin::world_t world;
+
+    kin::fixture_def_t ground_def;
+    ground_def.hw = 100.0f;
+    world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_static)->create_fixture(ground_def);
+
+    kin::fixture_def_t small_def;
+    small_def.hw = 0.4f;
+    small_def.hh = 0.4f;
+    for(int i = 0; i < 80; i++) {
+        world.create_rigid_body({(float)i - 39.5f, 1.4f}, 0.0f, kin::body_type_dynamic)->create_fixture(small_def);
+    }
+
+    kin::fixture_def_t plank_def;
+    plank_def.hw = 40.0f;
+    plank_def.hh = 0.5f;
+    kin::rigid_body_t* plank = world.create_rigid_body({0.0f, 2.3f}, 0.0f, kin::body_type_dynamic);
+    plank->create_fixture(plank_def);
+
+    for(int i = 0; i < 120; i++) {
+        world.update(0.016f, 8);
+    }
+
+    if(std::abs(plank->get_world_pos().y - 2.3f) > 0.1f) {
+        printf("a plank resting on more boxes than there are colors sank to %g\n", plank->get_world_pos().y);
+        return 1;
+    }
+
+    return 0;
+}
+
+// warm starting has to hold a tall column up with only two substeps, until it falls asleep
+int test_column() {
+    kin::world_t world;
+
+    kin::fixture_def_t ground_def;
+    ground_def.hw = 20.0f;
+    world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_static)->create_fixture(ground_def);
+
+    std::vector<kin::rigid_body_t*> column;
+    for(int i = 0; i < 10; i++) {
+        column.push_back(world.create_rigid_body({0.0f, 2.0f + (float)i * 2.0f}, 0.0f, kin::body_type_dynamic));
+        column.back()->create_fixture(kin::fixture_def_t());
+    }
+
+    for(int i = 0; i < 600; i++) {
+        world.update(0.016f, 2);
+    }
+
+    for(kin::rigid_body_t* body : column) {
+        if(body->is_awake()) {
+            printf("a column of ten boxes did not settle\n");
+            return 1;
+        }
+    }
+
+    const glm::vec2 top = column.back()->get_world_pos();
+    if(std::abs(top.x) > 0.05f || std::abs(top.y - 20.0f) > 0.1f) {
+        printf("the top of a column of ten boxes ended up at %g %g\n", top.x, top.y);
+        return 1;
+    }
+
+    return 0;
+}
+
+// a small deterministic generator for the randomized tests, uniform in [min, max)
+static float random_float(uint32_t& seed, float min, float max) {
+    seed = seed * 1664525u + 1013904223u;
+    return min + (max - min) * (float)(seed >> 8) / 16777216.0f;
+}
+
+// a collision proxy of a box with the given center, half extents and rotation
+static kin::collision_proxy_t make_proxy(glm::vec2 center, float hw, float hh, float rot) {
+    const glm::vec2 x_axis = {std::cos(rot), std::sin(rot)};
+    const glm::vec2 y_axis = {-x_axis.y, x_axis.x};
+
+    kin::collision_proxy_t proxy;
+    proxy.world_vertices[0] = center - x_axis * hw - y_axis * hh;
+    proxy.world_vertices[1] = center + x_axis * hw - y_axis * hh;
+    proxy.world_vertices[2] = center + x_axis * hw + y_axis * hh;
+    proxy.world_vertices[3] = center - x_axis * hw + y_axis * hh;
+    proxy.normals[0] = -x_axis;
+    proxy.normals[1] = -y_axis;
+
+    return proxy;
+}
+
+// every level of the batched seperating axis test has to agree with sat_test bit for bit,
+// and partial batches must not write past their last lane
+int test_sat_batch() {
+    uint32_t seed = 7;
+
+    for(int level = 0; level <= (int)kin::detect_simd_level(); level++) {
+        for(int trial = 0; trial < 2000; trial++) {
+            const uint32_t count = 1 + trial % kin::sat_batch_size;
+
+            kin::sat_batch_t batch = {};
+            kin::collision_proxy_t proxies1[kin::sat_batch_size], proxies2[kin::sat_batch_size];
+            for(uint32_t lane = 0; lane < count; lane++) {
+                proxies1[lane] = make_proxy({random_float(seed, -2.0f, 2.0f), random_float(seed, -2.0f, 2.0f)}, 
+                    random_float(seed, 0.1f, 1.5f), random_float(seed, 0.1f, 1.5f), random_float(seed, -3.2f, 3.2f));
+                proxies2[lane] = make_proxy({random_float(seed, -2.0f, 2.0f), random_float(seed, -2.0f, 2.0f)}, 
+                    random_float(seed, 0.1f, 1.5f), random_float(seed, 0.1f, 1.5f), random_float(seed, -3.2f, 3.2f));
+                batch.set(lane, proxies1[lane], proxies2[lane]);
+            }
+
+            kin::sat_batch_result_t result;
+            memset(&result, 0xff, sizeof(result));
+            kin::sat_test_batch(batch, count, result, (kin::simd_level_t)level);
+
+            for(uint32_t lane = 0; lane < kin::sat_batch_size; lane++) {
+                if(lane >= count) {
+                    if(result.hit[lane] != 0xff) {
+                        printf("sat_test_batch_%s wrote past the end of a partial batch\n", kin::simd_level_name((kin::simd_level_t)level));
+                        return 1;
+                    }
+
+                    continue;
+                }
+
+                kin::collision_manifold_t manifold;
+                const bool hit = kin::sat_test(proxies1[lane], proxies2[lane], manifold);
+
+                if(hit != (bool)result.hit[lane] || (hit && (memcmp(&manifold.depth, &result.depth[lane], sizeof(float)) != 0 ||
+                   memcmp(&manifold.normal.x, &result.normal_x[lane], sizeof(float)) != 0 || memcmp(&manifold.normal.y, &result.normal_y[lane], sizeof(float)) != 0))) {
+                    printf("sat_test_batch_%s disagrees with sat_test\n", kin::simd_level_name((kin::simd_level_t)level));
+                    return 1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+// every level of the batched transform has to give exactly what fixture_t::update_vertices does
+int test_transform_batch() {
+    kin::world_t world;
+    uint32_t seed = 11;
+
+    std::vector<kin::fixture_t*> fixtures;
+    for(int i = 0; i < 101; i++) {
+        glm::vec2 pos = {random_float(seed, -100.0f, 100.0f), random_float(seed, -100.0f, 100.0f)};
+        kin::rigid_body_t* body = world.create_rigid_body(pos, random_float(seed, -100.0f, 100.0f), kin::body_type_dynamic);
+
+        for(int j = 0; j < 1 + i % 3; j++) {
+            kin::fixture_def_t def;
+            def.hw      = random_float(seed, 0.1f, 3.0f);
+            def.hh      = random_float(seed, 0.1f, 3.0f);
+            def.rel_pos = {random_float(seed, -3.0f, 3.0f), random_float(seed, -3.0f, 3.0f)};
+            fixtures.push_back(body->create_fixture(def));
+        }
+    }
+
+    // adding a fixture moves the center of mass, which the fixtures before it don't see
+    for(kin::fixture_t* fixture : fixtures) {
+        fixture->update_vertices();
+    }
+
+    for(int level = 0; level <= (int)kin::detect_simd_level(); level++) {
+        for(size_t first = 0; first < fixtures.size(); first += kin::box_batch_size) {
+            const uint32_t count = (uint32_t)std::min<size_t>(kin::box_batch_size, fixtures.size() - first);
+
+            kin::box_batch_t batch = {};
+            for(uint32_t lane = 0; lane < count; lane++) {
+                const kin::fixture_t* fixture = fixtures[first + lane];
+                kin::rigid_body_t* body = fixture->body;
+
+                batch.pos_x[lane]  = fixture->pos.x;
+                batch.pos_y[lane]  = fixture->pos.y;
+                batch.hw[lane]     = fixture->hw;
+                batch.hh[lane]     = fixture->hh;
+                batch.com_x[lane]  = body->center_of_mass.x;
+                batch.com_y[lane]  = body->center_of_mass.y;
+                batch.body_x[lane] = body->pos().x;
+                batch.body_y[lane] = body->pos().y;
+                batch.sin[lane]    = body->psin();
+                batch.cos[lane]    = body->pcos();
+            }
+
+            kin::transform_box_batch(batch, count, (kin::simd_level_t)level);
+
+            for(uint32_t lane = 0; lane < count; lane++) {
+                kin::collision_proxy_t proxy;
+                batch.get(lane, proxy);
+
+                if(memcmp(&proxy, &world.proxy(fixtures[first + lane]->relement_id), sizeof(proxy)) != 0) {
+                    printf("transform_box_batch_%s disagrees with update_vertices\n", kin::simd_level_name((kin::simd_level_t)level));
+                    return 1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+// tiles are merged into as few rectangles as the greedy merge finds, and editing re-merges
+int test_tile_grid() {
+    kin::world_t world;
+
+    kin::tile_grid_def_t grid_def;
+    grid_def.width  = 20;
+    grid_def.height = 4;
+    kin::rigid_body_t* body = world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_static);
+    kin::tile_grid_t* grid = body->create_tile_grid(grid_def);
+
+    auto check = [&](uint32_t rectangles, uint32_t tiles) {
+        uint32_t fixtures = 0;
+        float area = 0.0f;
+        body->for_each_fixture([&](kin::fixture_t* fixture) {
+            fixtures++;
+            area += 4.0f * fixture->hw * fixture->hh;
+        });
+
+        return grid->rectangle_count() == rectangles && fixtures == rectangles && area == (float)tiles;
+    };
+
+    for(uint32_t y = 0; y < grid_def.height; y++) {
+        for(uint32_t x = 0; x < grid_def.width; x++) {
+            grid->set_tile(x, y, true);
+        }
+    }
+
+    // nothing changes until update
+    if(!check(0, 0)) {
+        printf("tile grid merged before update\n");
+        return 1;
+    }
+
+    // one rectangle per chunk
+    grid->update();
+    if(!check(2, 80)) {
+        printf("a solid tile grid was not merged into one rectangle per chunk\n");
+        return 1;
+    }
+
+    // a hole splits its chunk into the row below it, the columns on 
+    // either side and the column above it, the other chunk is left alone
+    grid->set_tile(5, 1, false);
+    grid->update();
+    if(!check(5, 79) || grid->get_tile(5, 1)) {
+        printf("a tile grid with a hole was not merged into 5 rectangles\n");
+        return 1;
+    }
+
+    grid->set_tile(5, 1, true);
+    grid->update();
+    if(!check(2, 80)) {
+        printf("filling a hole did not merge the rectangles again\n");
+        return 1;
+    }
+
+    // a box dropped on the grid comes to rest on top of it
+    kin::rigid_body_t* box = world.create_rigid_body({5.0f, 6.0f}, 0.0f, kin::body_type_dynamic);
+    box->create_fixture(kin::fixture_def_t());
+    for(int i = 0; i < 120; i++) {
+        world.update(0.016f, 8);
+    }
+
+    if(std::abs(box->get_world_pos().y - 5.0f) > 0.05f) {
+        printf("a box fell to %g on a tile grid\n", box->get_world_pos().y);
+        return 1;
+    }
+
+    return 0;
+}
+
+// the static tree has to find exactly what a brute force scan finds, after every rebuild
+int test_static_tree() {
+    uint32_t seed = 3;
+
+    auto random_box = [&](float extent, float size) {
+        kin::aabb_t box;
+        box.min[0] = random_float(seed, -extent, extent);
+        box.min[1] = random_float(seed, -extent, extent);
+        box.max[0] = box.min[0] + random_float(seed, 0.0f, size);
+        box.max[1] = box.min[1] + random_float(seed, 0.0f, size);
+        return box;
+    };
+
+    std::vector<kin::static_tree_t::entry_t> boxes;
+    for(uint32_t i = 0; i < 1000; i++) {
+        boxes.push_back({random_box(100.0f, 5.0f), i});
+    }
+
+    kin::static_tree_t tree;
+    for(uint32_t size : {0u, 1u, 8u, 9u, 65u, 1000u, 700u}) {
+        // build takes the entries, so it gets a copy
+        std::vector<kin::static_tree_t::entry_t> entries(boxes.begin(), boxes.begin() + size);
+        tree.build(entries);
+
+        for(int i = 0; i < 200; i++) {
+            const kin::aabb_t area = random_box(100.0f, 30.0f);
+
+            std::vector<uint32_t> found;
+            tree.query(area, [&](uint32_t id) { found.push_back(id); });
+
+            std::vector<uint32_t> expected;
+            for(uint32_t j = 0; j < size; j++) {
+                if(kin::aabb_collide(boxes[j].aabb, area)) {
+                    expected.push_back(boxes[j].id);
+                }
+            }
+
+            std::sort(found.begin(), found.end());
+            if(found != expected) {
+                printf("a static tree of %u boxes found %zu instead of %zu\n", size, found.size(), expected.size());
+                return 1;
+            }
+        }
+
+        // the next build sees some of the boxes moved
+        for(uint32_t j = 0; j < size; j += 7) {
+            boxes[j].aabb = random_box(100.0f, 5.0f);
+        }
+    }
+
+    // moving a static body rebuilds the tree before the next query
+    kin::world_t world;
+    kin::rigid_body_t* wall = world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_static);
+    wall->create_fixture(kin::fixture_def_t());
+    world.create_rigid_body({10.0f, 0.0f}, 0.0f, kin::body_type_static)->create_fixture(kin::fixture_def_t());
+
+    const kin::aabb_t areas[2] = {{{-0.5f, -0.5f}, {0.5f, 0.5f}}, {{29.5f, -0.5f}, {30.5f, 0.5f}}};
+    kin::fixture_t* results[2];
+    uint32_t counts[2];
+
+    world.query_aabbs(areas, 2, results, 1, counts);
+    if(counts[0] != 1 || counts[1] != 0) {
+        printf("static query failed\n");
+        return 1;
+    }
+
+    wall->set_position({30.0f, 0.0f});
+    world.query_aabbs(areas, 2, results, 1, counts);
+    if(counts[0] != 0 || counts[1] != 1) {
+        printf("static query after moving a static body failed\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+// runs a long side-scrolling scene once per broadphase, the results have to be identical
+int test_broadphases() {
+    const kin::broadphase_type_t types[] = {kin::broadphase_type_rtree, kin::broadphase_type_sap, kin::broadphase_type_grid, kin::broadphase_type_grid};
+    const char* names[] = {"rtree", "sap", "grid", "grid of small cells"};
+
+    kin::profiler_t profiler;
+    std::vector<glm::vec2> results[4];
+
+    for(int t = 0; t < 4; t++) {
+        kin::world_t world;
+        world.set_broadphase(types[t]);
+
+        // cells so small that every box is oversized, setting the same type again has to apply them
+        if(t == 3) {
+            kin::settings.grid_cell_size = 1.0f;
+            kin::settings.grid_max_cells = 4;
+            world.set_broadphase(types[t]);
+        }
+
+        kin::fixture_def_t ground_def;
+        ground_def.hw = 500.0f;
+        ground_def.hh = 1.0f;
+        world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_static)->create_fixture(ground_def);
+
+        std::vector<kin::rigid_body_t*> bodies;
+        for(int i = 0; i < 300; i++) {
+            glm::vec2 pos = {(float)i * 3.0f - 450.0f, 2.0f + (float)(i % 3) * 2.5f};
+            kin::rigid_body_t* body = world.create_rigid_body(pos, 0.0f, kin::body_type_dynamic);
+            body->create_fixture(kin::fixture_def_t());
+            body->apply_linear_velocity({(float)(i % 7) - 3.0f, 0.0f});
+            bodies.push_back(body);
+        }
+
+        int id = profiler.create_profile(names[t]);
+        profiler.start_profile(id);
+        for(int i = 0; i < 120; i++) {
+            world.update(0.016f, 8);
+        }
+        profiler.end_profile(id);
+
+        for(kin::rigid_body_t* body : bodies) {
+            results[t].push_back(body->get_world_pos());
+        }
+    }
+
+    kin::settings.grid_cell_size = kin::settings_t().grid_cell_size;
+    kin::settings.grid_max_cells = kin::settings_t().grid_max_cells;
+
+    profiler.print_profiles(-1);
+
+    for(int t = 1; t < 4; t++) {
+        if(memcmp(results[0].data(), results[t].data(), results[0].size() * sizeof(glm::vec2)) != 0) {
+            printf("%s and %s broadphases disagree\n", names[0], names[t]);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// fires a fast box at a thin wall with a single substep, speculative contacts have to stop it
+int test_speculative_contacts() {
+    kin::settings.speculative_contacts = true;
+
+    kin::world_t world({0.0f, 0.0f});
+
+    kin::fixture_def_t wall_def;
+    wall_def.hw = 0.05f;
+    wall_def.hh = 5.0f;
+    world.create_rigid_body({10.0f, 0.0f}, 0.0f, kin::body_type_static)->create_fixture(wall_def);
+
+    kin::fixture_def_t bullet_def;
+    bullet_def.hw = 0.1f;
+    bullet_def.hh = 0.1f;
+    kin::rigid_body_t* bullet = world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_dynamic);
+    bullet->create_fixture(bullet_def);
+    bullet->apply_linear_velocity({300.0f, 0.0f});
+
+    for(int i = 0; i < 60; i++) {
+        world.update(0.016f, 1);
+    }
+
+    kin::settings.speculative_contacts = false;
+
+    if(bullet->get_world_pos().x > 10.0f) {
+        printf("bullet tunneled through the wall\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+// the stats of an update, and a chrome trace of it that has to be well formed json
+int test_trace() {
+    kin::world_t world;
+    world.set_worker_count(2);
+
+    kin::fixture_def_t ground_def;
+    ground_def.hw = 50.0f;
+    world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_static)->create_fixture(ground_def);
+
+    for(int i = 0; i < 40; i++) {
+        glm::vec2 pos = {(float)(i % 8) * 2.2f - 8.0f, 2.0f + (float)(i / 8) * 2.0f};
+        world.create_rigid_body(pos, 0.0f, kin::body_type_dynamic)->create_fixture(kin::fixture_def_t());
+    }
+
+    world.clear_trace();
+    for(int i = 0; i < 3; i++) {
+        world.update(0.016f, 8);
+    }
+
+    const kin::step_stats_t& stats = world.get_step_stats();
+    if(stats.substeps != 8 || stats.pairs == 0 || stats.contacts == 0 || stats.contacts > stats.pairs) {
+        printf("step stats are wrong, %u substeps, %u pairs and %u contacts\n", stats.substeps, stats.pairs, stats.contacts);
+        return 1;
+    }
+
+#if KIN_PROFILE
+    // every phase ran, so every phase took some time
+    for(uint32_t phase = 0; phase < kin::step_phase_count; phase++) {
+        if(stats.phase_ns[phase] == 0) {
+            printf("phase %s was not timed\n", kin::step_phase_name((kin::step_phase_t)phase));
+            return 1;
+        }
+    }
+#endif
+
+    const char* path = "kin_test_trace.json";
+    if(!world.write_chrome_trace(path)) {
+        printf("could not write a chrome trace\n");
+        return 1;
+    }
+
+    std::string json;
+    FILE* file = fopen(path, "r");
+    for(int c = fgetc(file); c != EOF; c = fgetc(file)) {
+        json += (char)c;
+    }
+    fclose(file);
+    remove(path);
+
+    // brackets have to balance, there are no strings with brackets in a trace
+    int depth = 0;
+    for(char c : json) {
+        depth += (c == '{' || c == '[') - (c == '}' || c == ']');
+        if(depth < 0)
+            break;
+    }
+
+    if(depth != 0 || json.rfind("{\"traceEvents\":[", 0) != 0 || json.find("\"name\":\"main 0\"") == std::string::npos) {
+        printf("the chrome trace is malformed\n");
+        return 1;
+    }
+
+#if KIN_PROFILE
+    // the integrate phase of each substep of each update
+    size_t integrates = 0;
+    for(size_t at = json.find("\"name\":\"integrate\""); at != std::string::npos; at = json.find("\"name\":\"integrate\"", at + 1)) {
+        integrates++;
+    }
+
+    if(integrates != 3 * 8) {
+        printf("the chrome trace has %zu integrate events instead of %d\n", integrates, 3 * 8);
+        return 1;
+    }
+#endif
+
+    return 0;
+}
+
+// rolls a scene back and simulates it again, the results have to match bit for bit
+int test_snapshots() {
+    kin::world_t world;
+
+    kin::fixture_def_t ground_def;
+    ground_def.hw = 50.0f;
+    ground_def.hh = 1.0f;
+    world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_static)->create_fixture(ground_def);
+
+    for(int i = 0; i < 40; i++) {
+        glm::vec2 pos = {(float)(i % 8) * 2.2f - 8.0f, 3.0f + (float)(i / 8) * 2.5f};
+        kin::rigid_body_t* body = world.create_rigid_body(pos, 0.1f * (float)i, kin::body_type_dynamic);
+        body->create_fixture(kin::fixture_def_t());
+        body->apply_linear_velocity({(float)(i % 5) - 2.0f, 0.0f});
+    }
+
+    for(int i = 0; i < 30; i++) {
+        world.update(0.016f, 8);
+    }
+
+    std::vector<uint8_t> snapshot(world.snapshot_size());
+    world.save_snapshot(snapshot.data(), snapshot.size());
+    const uint64_t saved_hash = world.state_hash();
+
+    for(int i = 0; i < 30; i++) {
+        world.update(0.016f, 8);
+    }
+    const uint64_t expected_hash = world.state_hash();
+
+    if(!world.restore_snapshot(snapshot.data(), snapshot.size()) || world.state_hash() != saved_hash) {
+        printf("snapshot did not restore\n");
+        return 1;
+    }
+
+    for(int i = 0; i < 30; i++) {
+        world.update(0.016f, 8);
+    }
+
+    if(world.state_hash() != expected_hash) {
+        printf("simulating after a restore gave different results\n");
+        return 1;
+    }
+
+    // the snapshot no longer fits the world once a body is added
+    world.create_rigid_body({0.0f, 20.0f}, 0.0f, kin::body_type_dynamic);
+    if(world.restore_snapshot(snapshot.data(), snapshot.size())) {
+        printf("restored a snapshot of a different topology\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int test_scenes() {
+    kin::world_t world;
+
+    kin::fixture_def_t ground_def;
+    ground_def.hw = 50.0f;
+    ground_def.hh = 1.0f;
+    world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_static)->create_fixture(ground_def);
+
+    kin::tile_grid_def_t grid_def;
+    grid_def.width  = 40;
+    grid_def.height = 4;
+    grid_def.offset = {-20.0f, 0.0f};
+    kin::tile_grid_t* grid = world.create_rigid_body({0.0f, 1.0f}, 0.0f, kin::body_type_static)->create_tile_grid(grid_def);
+    for(uint32_t x = 0; x < grid_def.width; x++) {
+        grid->set_tile(x, 0, true);
+        grid->set_tile(x, x % 4, true);
+    }
+    grid->update();
+
+    for(int i = 0; i < 30; i++) {
+        kin::fixture_def_t def;
+        def.density     = 1.0f + (float)(i % 3);
+        def.restitution = 0.1f * (float)(i % 2);
+
+        glm::vec2 pos = {(float)(i % 6) * 2.5f - 6.0f, 8.0f + (float)(i / 6) * 2.5f};
+        kin::rigid_body_t* body = world.create_rigid_body(pos, 0.2f * (float)i, kin::body_type_dynamic);
+        body->create_fixture(def);
+        def.rel_pos = {0.5f, 1.0f};
+        def.hw      = 0.5f;
+        body->create_fixture(def);
+        body->apply_linear_velocity({(float)(i % 5) - 2.0f, 0.0f});
+    }
+
+    std::vector<uint8_t> scene;
+    world.save_scene(scene);
+
+    kin::world_t loaded;
+    if(!loaded.load_scene(scene.data(), scene.size()) || loaded.count() != world.count()) {
+        printf("scene did not load\n");
+        return 1;
+    }
+
+    for(int i = 0; i < 60; i++) {
+        world.update(0.016f, 8);
+        loaded.update(0.016f, 8);
+    }
+
+    if(loaded.state_hash() != world.state_hash()) {
+        printf("a loaded scene simulated differently\n");
+        return 1;
+    }
+
+    // a scene cut short must not create anything
+    if(loaded.load_scene(scene.data(), scene.size() - 1) || loaded.count() != world.count()) {
+        printf("loaded a truncated scene\n");
+        return 1;
+    }
+
+    // neither must a tile grid so large that its size in words wraps around
+    kin::scene_header_t header;
+    memcpy(&header, scene.data(), sizeof(header));
+
+    const uint32_t bad_sizes[2][2] = {{0xffffffff, 4}, {40, 0x80000000}};
+    for(const uint32_t (&size)[2] : bad_sizes) {
+        std::vector<uint8_t> corrupt = scene;
+        kin::scene_tile_grid_t grid;
+        memcpy(&grid, corrupt.data() + header.tile_grids.offset, sizeof(grid));
+        grid.width  = size[0];
+        grid.height = size[1];
+        memcpy(corrupt.data() + header.tile_grids.offset, &grid, sizeof(grid));
+
+        if(loaded.load_scene(corrupt.data(), corrupt.size()) || loaded.count() != world.count()) {
+            printf("loaded a scene with a %ux%u tile grid\n", size[0], size[1]);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int test_bulk_creation() {
+    kin::world_t single;
+    kin::world_t bulk;
+
+    kin::fixture_def_t fixture_defs[3];
+    fixture_defs[1].rel_pos = {1.5f, 0.0f};
+    fixture_defs[1].density = 2.0f;
+    fixture_defs[2].rel_pos = {0.0f, 1.5f};
+    fixture_defs[2].hw      = 0.5f;
+
+    std::vector<kin::body_def_t> body_defs;
+    for(int i = 0; i < 50; i++) {
+        kin::body_def_t& def = body_defs.emplace_back();
+        def.pos           = {(float)(i % 10) * 5.0f - 25.0f, 4.0f + (float)(i / 10) * 5.0f};
+        def.rot           = 0.3f * (float)i;
+        def.fixtures      = fixture_defs;
+        def.fixture_count = 1 + i % 3;
+    }
+
+    kin::fixture_def_t ground_def;
+    ground_def.hw = 60.0f;
+    kin::body_def_t& ground = body_defs.emplace_back();
+    ground.type          = kin::body_type_static;
+    ground.fixtures      = &ground_def;
+    ground.fixture_count = 1;
+
+    for(const kin::body_def_t& def : body_defs) {
+        kin::rigid_body_t* body = single.create_rigid_body(def.pos, def.rot, def.type);
+        for(uint32_t i = 0; i < def.fixture_count; i++) {
+            body->create_fixture(def.fixtures[i]);
+        }
+    }
+
+    std::vector<kin::rigid_body_t*> bodies(body_defs.size());
+    bulk.create_rigid_bodies(body_defs.data(), (uint32_t)body_defs.size(), bodies.data());
+
+    // mass is added up in the same order, so it has to come out exactly the same
+    size_t i = 0;
+    bool same_mass = true;
+    single.for_each_body([&](kin::rigid_body_t* body) {
+        same_mass &= body->mass == bodies[i]->mass && body->inertia == bodies[i]->inertia && 
+                     body->center_of_mass == bodies[i]->center_of_mass;
+        i++;
+    });
+
+    if(!same_mass) {
+        printf("bulk created bodies have different mass\n");
+        return 1;
+    }
+
+    for(int i = 0; i < 60; i++) {
+        single.update(0.016f, 8);
+        bulk.update(0.016f, 8);
+    }
+
+    if(single.state_hash() != bulk.state_hash()) {
+        printf("bulk created bodies simulated differently\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int test_queries() {
+    kin::world_t world;
+
+    kin::fixture_def_t ground_def;
+    ground_def.hw = 20.0f;
+    kin::fixture_t* ground = world.create_rigid_body({0.0f, 0.0f}, 0.0f, kin::body_type_static)->create_fixture(ground_def);
+    // a diamond, whose box is much larger than the diamond itself
+    kin::fixture_t* diamond = world.create_rigid_body({0.0f, 5.0f}, 0.7853982f, kin::body_type_dynamic)->create_fixture(kin::fixture_def_t());
+    kin::fixture_t* box = world.create_rigid_body({5.0f, 5.0f}, 0.0f, kin::body_type_dynamic)->create_fixture(kin::fixture_def_t());
+
+    glm::vec2 points[3] = {{0.0f, 6.3f}, {0.9f, 5.9f}, {5.5f, 4.5f}};
+    kin::fixture_t* point_results[3];
+    uint32_t point_counts[3];
+    world.query_points(points, 3, point_results, 1, point_counts);
+
+    if(point_counts[0] != 1 || point_results[0] != diamond || point_counts[1] != 0 || point_counts[2] != 1 || point_results[2] != box) {
+        printf("point query failed\n");
+        return 1;
+    }
+
+    kin::aabb_t area = {{-30.0f, -2.0f}, {30.0f, 10.0f}};
+    kin::fixture_t* area_results[2];
+    uint32_t area_count;
+    world.query_aabbs(&area, 1, area_results, 2, &area_count);
+
+    if(area_count != 3 || area_results[0]->relement_id > area_results[1]->relement_id) {
+        printf("aabb query failed\n");
+        return 1;
+    }
+
+    // straight down through the right face of the diamond and into the ground
+    kin::ray_t ray = {{0.2f, 20.0f}, {0.0f, -40.0f}};
+    kin::raycast_hit_t closest;
+    world.raycast_closest(&ray, 1, &closest);
+
+    const float top = 5.0f + 1.4142136f - 0.2f;
+    if(closest.fixture != diamond || std::abs(closest.point.y - top) > 1e-3f || closest.normal.x <= 0.0f || closest.normal.y <= 0.0f) {
+        printf("closest raycast failed\n");
+        return 1;
+    }
+
+    kin::raycast_hit_t all_hits[4];
+    uint32_t hit_count;
+    world.raycast_all(&ray, 1, all_hits, 4, &hit_count);
+
+    if(hit_count != 2 || all_hits[0].fixture != diamond || all_hits[1].fixture != ground || std::abs(all_hits[1].point.y - 1.0f) > 1e-3f) {
+        printf("raycast failed\n");
+        return 1;
+    }
+
+    // a teleported dynamic body is found where it is now, without an update in between
+    box->body->set_position({30.0f, 5.0f});
+
+    glm::vec2 teleport_points[2] = {{5.0f, 5.0f}, {30.5f, 5.5f}};
+    world.query_points(teleport_points, 2, point_results, 1, point_counts);
+
+    kin::ray_t teleport_ray = {{30.0f, 20.0f}, {0.0f, -40.0f}};
+    world.raycast_closest(&teleport_ray, 1, &closest);
+
+    if(point_counts[0] != 0 || point_counts[1] != 1 || point_results[1] != box || closest.fixture != box || std::abs(closest.point.y - 6.0f) > 1e-3f) {
+        printf("query after a teleport failed\n");
+        return 1;
+    }
+
+    // large batches go across the thread pool and must give the same results
+    std::vector<kin::ray_t> rays;
+    for(int i = 0; i < 2000; i++) {
+        rays.push_back({{(float)(i % 200) * 0.1f - 10.0f, 20.0f}, {(float)(i / 200) - 5.0f, -40.0f}});
+    }
+
+    std::vector<kin::raycast_hit_t> hits(rays.size());
+    world.raycast_closest(rays.data(), (uint32_t)rays.size(), hits.data());
+
+    world.set_worker_count(3);
+    std::vector<kin::raycast_hit_t> threaded_hits(rays.size());
+    world.raycast_closest(rays.data(), (uint32_t)rays.size(), threaded_hits.data());
+
+    for(size_t i = 0; i < rays.size(); i++) {
+        if(hits[i].fixture != threaded_hits[i].fixture || hits[i].fraction != threaded_hits[i].fraction) {
+            printf("threaded raycasts gave different results\n");
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int test_rotation() {
+    // the bound documented in math.hpp
+    float worst = 0.0f;
+    for(int i = -200000; i <= 200000; i++) {
+        const float x = (float)i * 0.04f;
+
+        float sin, cos;
+        kin::fast_sincos(x, sin, cos);
+        worst = std::max(worst, (float)std::abs(sin - std::sin((double)x)));
+        worst = std::max(worst, (float)std::abs(cos - std::cos((double)x)));
+    }
+
+    if(worst > 1e-7f) {
+        printf("fast_sincos is off by %g\n", worst);
+        return 1;
+    }
+
+    // past the documented range, and for values that don't fit in an int, it has to stay accurate
+    for(float x : {8192.5f, -1e5f, 3.5e9f, -1e30f, std::numeric_limits<float>::max()}) {
+        float sin, cos;
+        kin::fast_sincos(x, sin, cos);
+
+        if(std::abs(sin - std::sin((double)x)) > 1e-6 || std::abs(cos - std::cos((double)x)) > 1e-6) {
+            printf("fast_sincos(%g) is off\n", x);
+            return 1;
+        }
+    }
+
+    for(float x : {std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN()}) {
+        float sin, cos;
+        kin::fast_sincos(x, sin, cos);
+
+        if(!std::isnan(sin) || !std::isnan(cos)) {
+            printf("fast_sincos(%g) is not nan\n", x);
+            return 1;
+        }
+    }
+
+    // the array version has to give the same bits as the scalar one, on either side of the range
+    std::vector<float> angles = {0.0f, 1.0f, -2.5f, 8192.0f, 8192.5f, -3.5e9f, 100.0f, std::numeric_limits<float>::quiet_NaN()};
+    uint32_t seed = 1;
+    for(int i = 0; i < 37; i++) {
+        angles.push_back(random_float(seed, -1e4f, 1e4f));
+    }
+
+    std::vector<float> sins(angles.size()), coss(angles.size());
+    kin::fast_sincos(angles.data(), sins.data(), coss.data(), (uint32_t)angles.size());
+
+    for(size_t i = 0; i < angles.size(); i++) {
+        float sin, cos;
+        kin::fast_sincos(angles[i], sin, cos);
+
+        const bool same_sin = std::isnan(sin) ? std::isnan(sins[i]) : sin == sins[i];
+        const bool same_cos = std::isnan(cos) ? std::isnan(coss[i]) : cos == coss[i];
+        if(!same_sin || !same_cos) {
+            printf("fast_sincos over an array differs at %g\n", angles[i]);
+            return 1;
+        }
+    }
+
+    // a body spinning freely for ten seconds should stay a unit rotation at the angle it spun to
+    kin::world_t world({0.0f, 0.0f});
+    kin::rigid_body_t* body = world.create_rigid_body({0.0f, 0.0f}, 0.5f, kin::body_type_dynamic);
+    body->create_fixture(kin::fixture_def_t());
+    body->apply_angular_velocity(3.0f);
+
+    for(int i = 0; i < 625; i++) {
+        world.update(0.016f, 8);
+    }
+
+    const float length = std::sqrt(body->psin() * body->psin() + body->pcos() * body->pcos());
+    const float angle  = std::remainder(0.5f + 3.0f * 10.0f, 2.0f * 3.14159265f);
+    if(std::abs(length - 1.0f) > 1e-5f || std::abs(body->rot() - angle) > 1e-3f) {
+        printf("integrated rotation drifted\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int main() {
+    kin::print_test();
 
     kin::world_t world;
 
@@ -50,5 +1198,64 @@ int main() {
     // if we can return, that means no seg faults. So its basically
     // stable enough
     
+    if(test_broadphase_stats() != 0)
+        return 1;
+
+    if(test_sleep() != 0)
+        return 1;
+
+    if(test_worker_counts() != 0)
+        return 1;
+
+    if(test_position_correction() != 0)
+        return 1;
+
+    if(test_contact_coloring() != 0)
+        return 1;
+
+    if(test_column() != 0)
+        return 1;
+
+    if(test_sat_batch() != 0)
+        return 1;
+
+    if(test_transform_batch() != 0)
+        return 1;
+
+    if(test_tile_grid() != 0)
+        return 1;
+
+    if(test_static_tree() != 0)
+        return 1;
+
+    if(test_trace() != 0)
+        return 1;
+
+    if(test_broadphases() != 0)
+        return 1;
+
+    if(test_speculative_contacts() != 0)
+        return 1;
+
+    if(test_snapshots() != 0)
+        return 1;
+
+    if(test_scenes() != 0)
+        return 1;
+
+    if(test_bulk_creation() != 0)
+        return 1;
+
+    if(test_queries() != 0)
+        return 1;
+
+    if(test_rotation() != 0)
+        return 1;
+
+    for(kin::broadphase_type_t type : {kin::broadphase_type_rtree, kin::broadphase_type_sap, kin::broadphase_type_grid}) {
+        if(test_update_allocations(type) != 0)
+            return 1;
+    }
+
     return 0;
 }
\ No newline at end of file